@@ -1,45 +1,39 @@
 #include <windows.h>
 #include <string>
 #include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "plugin/PluginInterface.h"
 #include "plugin/Scintilla.h"
 #include "plugin/Notepad_plus_msgs.h"
-
-// Scintilla constants
-#ifndef SCI_SETLEXER
-#define SCI_SETLEXER 4001
-#endif
-#ifndef SCLEX_MARKDOWN
-#define SCLEX_MARKDOWN 55
-#endif
-
-// Markdown lexer styles
-#define SCE_MARKDOWN_DEFAULT 0
-#define SCE_MARKDOWN_LINE_BEGIN 1
-#define SCE_MARKDOWN_STRONG1 2
-#define SCE_MARKDOWN_STRONG2 3
-#define SCE_MARKDOWN_EM1 4
-#define SCE_MARKDOWN_EM2 5
-#define SCE_MARKDOWN_HEADER1 6
-#define SCE_MARKDOWN_HEADER2 7
-#define SCE_MARKDOWN_HEADER3 8
-#define SCE_MARKDOWN_HEADER4 9
-#define SCE_MARKDOWN_HEADER5 10
-#define SCE_MARKDOWN_HEADER6 11
-#define SCE_MARKDOWN_PRECHAR 12
-#define SCE_MARKDOWN_ULIST_ITEM 13
-#define SCE_MARKDOWN_OLIST_ITEM 14
-#define SCE_MARKDOWN_BLOCKQUOTE 15
-#define SCE_MARKDOWN_STRIKEOUT 16
-#define SCE_MARKDOWN_HRULE 17
-#define SCE_MARKDOWN_LINK 18
-#define SCE_MARKDOWN_CODE 19
-#define SCE_MARKDOWN_CODE2 20
-#define SCE_MARKDOWN_CODEBK 21
+#include "plugin/Docking.h"
+#include "plugin/dockingResource.h"
+#include "core/MarkdownStyles.h"
+#include "core/MarkdownILexer.h"
+#include "core/NotificationQueue.h"
+#include "core/ScintillaCall.h"
+#include "core/StylePalette.h"
+#include "core/MarkdownThemes.h"
+#include "core/DocumentView.h"
+#include "core/StyleWorker.h"
+#include "core/TaskScheduler.h"
+#include "core/DocumentBlocks.h"
+#include "core/LineIndex.h"
+#include "core/HeadingIndex.h"
+#include "core/WorkspaceIndex.h"
+#include "core/LinkChecker.h"
+#include "core/LinkCompletion.h"
+#include "core/MarkdownSummary.h"
 
 const TCHAR NPP_PLUGIN_NAME[] = TEXT("Better Markdown");
-const int nbFunc = 3;
+const int nbFunc = 7;
 
 FuncItem funcItem[nbFunc];
 NppData nppData;
@@ -47,6 +41,162 @@ HINSTANCE _gModule;
 
 bool g_stylesEnabled = true;
 
+// Lines styled on either side of the viewport before returning to the UI.
+// The rest of the document is lexed on a worker thread, workerJobBytes at a
+// time, and an idle timer commits the styles in runs of commitRunBytes for
+// at most idleSliceMs per tick.
+const Sci_Position visibleMarginLines = 100;
+const Sci_Position idleChunkBytes = 256 * 1024;
+const Sci_Position workerJobBytes = 64 * 1024 * 1024;
+const size_t commitRunBytes = 1024 * 1024;
+const ULONGLONG idleSliceMs = 15;
+
+// An edit cancels the background pass; it starts again once typing has
+// paused this long.
+const UINT editQuietMs = 300;
+
+// The document being styled in the background, if any.
+struct IdleStyling
+{
+    HWND hScintilla = nullptr;
+    sptr_t document = 0;        // SCI_GETDOCPOINTER of the document
+    UINT_PTR bufferId = 0;      // NPPM_GETCURRENTBUFFERID of the document
+    UINT_PTR timer = 0;
+    bool lexing = false;        // a job is with the worker
+    StyleResult result;         // worker output being committed
+};
+
+IdleStyling g_idleStyling;
+
+// The worker posts this through NPPM_MSGTOPLUGIN when a result is waiting,
+// so messageProc() takes it on the UI thread without polling.
+#define BETTERMD_MSG_STYLES_READY 1
+TCHAR g_moduleName[MAX_PATH] = {0};
+CommunicationInfo g_stylesReady = { BETTERMD_MSG_STYLES_READY, g_moduleName, nullptr };
+
+// Posted the same way when a link check has finished.
+#define BETTERMD_MSG_LINKS_READY 2
+CommunicationInfo g_linksReady = { BETTERMD_MSG_LINKS_READY, g_moduleName, nullptr };
+
+void wakeForStyles()
+{
+    ::PostMessage(nppData._nppHandle, NPPM_MSGTOPLUGIN, (WPARAM)g_moduleName, (LPARAM)&g_stylesReady);
+}
+
+// Background jobs, keyed by buffer. The buffer on screen goes first, and
+// switching away from a buffer or closing it cancels its jobs.
+TaskScheduler g_scheduler;
+StyleWorker g_styleWorker(g_scheduler, wakeForStyles);
+UINT_PTR g_activeBuffer = 0;
+
+// Bumped on every text change. A worker result lexed from an older version
+// no longer matches the text and is thrown away.
+uint64_t g_documentVersion = 0;
+
+// Block trees, line indexes and heading indexes of the buffers a feature
+// has asked for, kept current from SCN_MODIFIED and dropped when the buffer
+// closes. Each is built on first use.
+struct BufferIndexes
+{
+    sptr_t document = 0;        // SCI_GETDOCPOINTER of the buffer
+    std::unique_ptr<DocumentBlocks> blocks;
+    std::unique_ptr<LineIndex> lines;
+    std::unique_ptr<HeadingIndex> headings;     // needs blocks
+};
+
+std::map<UINT_PTR, std::unique_ptr<BufferIndexes>> g_bufferIndexes;
+
+// The Markdown styles last sent to the main and second Scintilla.
+ViewStyles g_viewStyles[2];
+
+// Direct-function callers for the main and second Scintilla, set up on
+// first use.
+DirectScintillaCall g_scintilla[2];
+
+// Buffer notifications waiting for the styles to be applied. They are handled
+// from a timer, which Windows only fires once the message queue is empty, so
+// a burst of notifications is handled once, for the buffer left on screen.
+NotificationQueue g_notifications;
+UINT_PTR g_notificationTimer = 0;
+
+// The outline panel: the headings of the buffer on screen in a list box,
+// docked through NPPM_DMMREGASDCKDLG. The list is filled when a buffer is
+// shown; after that an edit only replaces the entries it changed.
+struct OutlinePanel
+{
+    HWND hPanel = nullptr;
+    HWND hList = nullptr;
+    bool visible = false;
+    UINT_PTR bufferId = 0;      // buffer the list shows, 0 for none
+    int current = -1;           // entry of the section holding the caret
+    tTbData dockData;
+};
+
+OutlinePanel g_outline;
+const int outlineFuncIndex = 2;
+
+// The workspace index: every Markdown file under Notepad++'s current
+// directory and in the session, kept in the plugin config directory. It is
+// refreshed in the background at startup, from the menu and for each saved
+// file. Refreshes run one after another, each taking whatever was asked for
+// since the last one started, and only stop early when Notepad++ closes.
+struct Workspace
+{
+    std::mutex mutex;                                   // guards the fields below
+    std::shared_ptr<const WorkspaceIndex> index;
+    std::shared_ptr<const PathCompletion> paths;        // over index, for link completion
+    WorkspaceBuild lastBuild;                           // of index, for the About box
+    std::filesystem::path root;
+    std::filesystem::path indexPath;
+    bool scan = false;                                  // the next refresh lists root again
+    std::vector<std::filesystem::path> sessionFiles;    // for the next scan
+    std::vector<std::filesystem::path> savedFiles;      // saved since the last refresh started
+
+    std::mutex refreshMutex;                            // held by the refresh running
+    CancelToken shutdown;
+};
+
+Workspace g_workspace;
+
+// The broken links of the last check, docked like the outline. Checks run
+// as a JOB_LINT job, a new one superseding the last, and hand their result
+// over in pending; picking an entry opens the file at the link. The checker
+// outlives the checks so its directory listings and headings are reused.
+struct LinksPanel
+{
+    HWND hPanel = nullptr;
+    HWND hList = nullptr;
+    bool visible = false;
+    std::filesystem::path root;         // entries are shown relative to it
+    std::vector<BrokenLink> links;      // one per list entry
+    tTbData dockData;
+
+    std::mutex mutex;                   // guards pending
+    std::unique_ptr<std::vector<BrokenLink>> pending;
+};
+
+LinksPanel g_links;
+LinkChecker g_linkChecker;
+const int linksFuncIndex = 5;
+
+// Link completion: each character typed inside a link destination or a
+// reference label shows the matches for what is typed so far. Paths come
+// from the workspace's PathCompletion, the anchors of the document itself
+// from its HeadingIndex, and those of other files and the reference labels
+// from the workspace index, so nothing is listed or parsed per keystroke.
+// The list is shown with Scintilla settings of its own, and the ones it
+// replaced are put back once the list is gone.
+struct LinkCompletionList
+{
+    bool showing = false;
+    HWND hScintilla = nullptr;
+    sptr_t autoHide = 1;
+    sptr_t ignoreCase = 0;
+};
+
+LinkCompletionList g_completion;
+const size_t completionLimit = 100;
+
 // Function declarations
 void pluginInit(HANDLE hModule);
 void pluginCleanUp();
@@ -55,9 +205,77 @@ void commandMenuCleanUp();
 void toggleStyles();
 void resetStyles();
 void about();
+void toggleOutline();
+void indexWorkspace();
+void checkLinks();
+void checkWorkspaceLinks();
 bool isMarkdownFile();
 HWND getCurrentScintilla();
 void applyMarkdownStyles();
+bool hasMarkdownLexer(HWND hScintilla);
+bool hasMarkdownLexer(ScintillaCall& sci);
+bool installMarkdownLexer(HWND hScintilla);
+void forwardEdit(const SCNotification* notifyCode);
+void colouriseVisibleFirst(HWND hScintilla);
+void stopIdleStyling();
+void pauseIdleTimer();
+void submitStyleJob(HWND hScintilla, Sci_Position from);
+void receiveStyles();
+void supersedeStyling(const SCNotification* notifyCode);
+void bufferActivated(const SCNotification* notifyCode);
+void bufferClosed(const SCNotification* notifyCode);
+BufferIndexes& currentIndexes();
+std::shared_ptr<const BlockSnapshot> currentBlocks();
+std::shared_ptr<const LineSnapshot> currentLines();
+const HeadingIndex& currentHeadings();
+void updateIndexes(const SCNotification* notifyCode);
+bool createOutlinePanel();
+void refreshOutline();
+void updateOutline(const HeadingIndex& index, UINT_PTR bufferId, const HeadingChange& change, ScintillaCall& sci);
+void updateOutlineSection();
+void jumpToHeading(int index);
+LRESULT CALLBACK outlineProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+std::filesystem::path workspaceIndexPath(const std::filesystem::path& root);
+void requestWorkspaceScan();
+void workspaceFileSaved(const SCNotification* notifyCode);
+void postWorkspaceRefresh();
+void refreshWorkspace();
+bool createLinksPanel();
+void showLinksPanel(const wchar_t* status);
+void postLinkCheck(std::function<std::vector<BrokenLink>(const CancelToken&)> check);
+void receiveLinks();
+void jumpToLink(int index);
+LRESULT CALLBACK linksProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+void completeLink(const SCNotification* notifyCode);
+std::vector<std::string> linkCompletions(const LinkCompletionContext& context);
+void endLinkCompletion();
+void CALLBACK idleStylingTick(HWND, UINT, UINT_PTR, DWORD);
+double nowMs();
+void postNotification(const SCNotification* notifyCode, PendingKind kind);
+void stopNotificationTimer();
+void CALLBACK notificationTick(HWND, UINT, UINT_PTR, DWORD);
+
+// A caller for any Scintilla window; not valid when hScintilla is not one.
+// The status variant of the direct function is used where Scintilla
+// provides it.
+DirectScintillaCall directCall(HWND hScintilla)
+{
+    const sptr_t ptr = (sptr_t)::SendMessage(hScintilla, SCI_GETDIRECTPOINTER, 0, 0);
+    const sptr_t statusFn = (sptr_t)::SendMessage(hScintilla, SCI_GETDIRECTSTATUSFUNCTION, 0, 0);
+    if (statusFn) return DirectScintillaCall(reinterpret_cast<SciFnDirectStatus>(statusFn), ptr);
+    return DirectScintillaCall(reinterpret_cast<SciFnDirect>(::SendMessage(hScintilla, SCI_GETDIRECTFUNCTION, 0, 0)), ptr);
+}
+
+// The caller for hScintilla, which must be one of the two views.
+ScintillaCall& scintilla(HWND hScintilla)
+{
+    DirectScintillaCall& call = g_scintilla[(hScintilla == nppData._scintillaSecondHandle) ? 1 : 0];
+    if (!call.valid()) call = directCall(hScintilla);
+    return call;
+}
+
+ViewStyles* viewStylesFor(HWND hScintilla);
+void invalidateViewStyles();
 
 BOOL APIENTRY DllMain(HANDLE hModule, DWORD reasonForCall, LPARAM /*lpReserved*/)
 {
@@ -76,10 +294,18 @@ BOOL APIENTRY DllMain(HANDLE hModule, DWORD reasonForCall, LPARAM /*lpReserved*/
 void pluginInit(HANDLE hModule)
 {
     _gModule = (HINSTANCE)hModule;
+
+    // NPPM_MSGTOPLUGIN finds plugins by their file name.
+    TCHAR path[MAX_PATH] = {0};
+    ::GetModuleFileName(_gModule, path, MAX_PATH);
+    const TCHAR* name = _tcsrchr(path, TEXT('\\'));
+    lstrcpyn(g_moduleName, name ? name + 1 : path, MAX_PATH);
 }
 
 void pluginCleanUp()
 {
+    stopIdleStyling();
+    stopNotificationTimer();
 }
 
 void commandMenuInit()
@@ -88,6 +314,11 @@ void commandMenuInit()
 
 void commandMenuCleanUp()
 {
+    stopIdleStyling();
+    g_workspace.shutdown.cancel();
+    g_scheduler.stop();
+    stopNotificationTimer();
+    g_notifications.clear();
 }
 
 HWND getCurrentScintilla()
@@ -125,6 +356,418 @@ bool isMarkdownFile()
     return false;
 }
 
+bool hasMarkdownLexer(HWND hScintilla)
+{
+    return hasMarkdownLexer(scintilla(hScintilla));
+}
+
+bool hasMarkdownLexer(ScintillaCall& sci)
+{
+    char name[64] = {0};
+    const sptr_t len = sci.call(SCI_GETLEXERLANGUAGE);
+    if (len <= 0 || len >= (sptr_t)sizeof(name)) return false;
+    sci.call(SCI_GETLEXERLANGUAGE, 0, (sptr_t)name);
+    return strcmp(name, BETTERMD_LEXER_NAME) == 0;
+}
+
+// Returns true when the lexer had to be installed.
+bool installMarkdownLexer(HWND hScintilla)
+{
+    // Notepad++ installs its own lexer whenever a buffer is activated, so only
+    // replace it when ours is not already there.
+    if (hasMarkdownLexer(hScintilla)) return false;
+
+    scintilla(hScintilla).call(SCI_SETILEXER, 0, (sptr_t)MarkdownILexer::create());
+    return true;
+}
+
+ViewStyles* viewStylesFor(HWND hScintilla)
+{
+    if (hScintilla == nppData._scintillaMainHandle) return &g_viewStyles[0];
+    if (hScintilla == nppData._scintillaSecondHandle) return &g_viewStyles[1];
+    return nullptr;
+}
+
+void invalidateViewStyles()
+{
+    for (ViewStyles& view : g_viewStyles) view.theme = nullptr;
+}
+
+// Every window showing a document notifies for its edits. Only the first of
+// the current view, the other view and hScintilla itself that shows the
+// document passes each edit on.
+bool reportsEdits(HWND hScintilla, sptr_t documentPointer)
+{
+    HWND hCurrent = getCurrentScintilla();
+    const HWND views[] = { hCurrent,
+                           (hCurrent == nppData._scintillaMainHandle) ? nppData._scintillaSecondHandle
+                                                                      : nppData._scintillaMainHandle };
+    for (HWND view : views) {
+        if (view == hScintilla) return true;
+        if (scintilla(view).call(SCI_GETDOCPOINTER) == documentPointer) return false;
+    }
+    return true;
+}
+
+// Tell the lexer which lines an edit touched, so its next pass can stop as
+// soon as the line states match the previous pass again. The lexer belongs
+// to the document, so edits made through any window showing it count.
+void forwardEdit(const SCNotification* notifyCode)
+{
+    HWND hScintilla = (HWND)notifyCode->nmhdr.hwndFrom;
+    const bool isView = hScintilla == nppData._scintillaMainHandle || hScintilla == nppData._scintillaSecondHandle;
+    DirectScintillaCall other;
+    if (!isView) {
+        other = directCall(hScintilla);
+        if (!other.valid()) return;
+    }
+    ScintillaCall& sci = isView ? scintilla(hScintilla) : other;
+    if (!reportsEdits(hScintilla, sci.call(SCI_GETDOCPOINTER)) || !hasMarkdownLexer(sci)) return;
+
+    LexerEdit edit;
+    edit.line = sci.call(SCI_LINEFROMPOSITION, notifyCode->position);
+    edit.linesAdded = notifyCode->linesAdded;
+    edit.lengthAdded = (notifyCode->modificationType & SC_MOD_INSERTTEXT) ? notifyCode->length : -notifyCode->length;
+    sci.call(SCI_PRIVATELEXERCALL, BETTERMD_CALL_EDIT, (sptr_t)&edit);
+}
+
+void stopIdleStyling()
+{
+    if (g_idleStyling.timer) ::KillTimer(NULL, g_idleStyling.timer);
+    g_styleWorker.cancel();
+    g_idleStyling = IdleStyling();
+}
+
+// The timer only runs while a result is being committed.
+void pauseIdleTimer()
+{
+    if (g_idleStyling.timer) ::KillTimer(NULL, g_idleStyling.timer);
+    g_idleStyling.timer = 0;
+}
+
+// Style the lines on screen, plus a margin, straight away and leave the rest
+// of the document to the worker. Lines above the viewport that are not
+// styled yet are included when they are few; otherwise the viewport is
+// styled from the nearest known line state and corrected once the worker
+// reaches it.
+void colouriseVisibleFirst(HWND hScintilla)
+{
+    stopIdleStyling();
+
+    ScintillaCall& sci = scintilla(hScintilla);
+    const Sci_Position length = sci.call(SCI_GETLENGTH);
+    const Sci_Position lineCount = sci.call(SCI_GETLINECOUNT);
+    const Sci_Position topLine = sci.call(SCI_DOCLINEFROMVISIBLE, sci.call(SCI_GETFIRSTVISIBLELINE));
+    const Sci_Position onScreen = sci.call(SCI_LINESONSCREEN);
+
+    const Sci_Position firstLine = std::max<Sci_Position>(0, topLine - visibleMarginLines);
+    const Sci_Position lastLine = topLine + onScreen + visibleMarginLines;
+    Sci_Position start = sci.call(SCI_POSITIONFROMLINE, firstLine);
+    const Sci_Position end = (lastLine < lineCount) ? sci.call(SCI_POSITIONFROMLINE, lastLine) : length;
+
+    const Sci_Position styledTo = sci.call(SCI_GETENDSTYLED);
+    Sci_Position idleFrom = styledTo;
+    if (styledTo < end) {
+        if (start - styledTo <= idleChunkBytes) {
+            start = styledTo;
+            idleFrom = end;
+        }
+        sci.call(SCI_COLOURISE, start, end);
+    }
+    if (idleFrom >= length) return;
+
+    g_idleStyling.hScintilla = hScintilla;
+    g_idleStyling.document = sci.call(SCI_GETDOCPOINTER);
+    g_idleStyling.bufferId = (UINT_PTR)::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+    submitStyleJob(hScintilla, idleFrom);
+}
+
+// Copy up to workerJobBytes of whole lines, from the line before the one
+// holding from, and hand them to the worker. The line before is lexed again
+// because it was last styled without the line after it, its setext lookahead.
+void submitStyleJob(HWND hScintilla, Sci_Position from)
+{
+    if (!g_stylesEnabled || !hasMarkdownLexer(hScintilla)) {
+        stopIdleStyling();
+        return;
+    }
+    ScintillaCall& sci = scintilla(hScintilla);
+    const Sci_Position length = sci.call(SCI_GETLENGTH);
+    const Sci_Position line = sci.call(SCI_LINEFROMPOSITION, from);
+
+    StyleJob job;
+    job.version = g_documentVersion;
+    job.firstLine = (line > 0) ? line - 1 : 0;
+    job.startPos = sci.call(SCI_POSITIONFROMLINE, job.firstLine);
+    job.initialState = (job.firstLine > 0) ? (int)sci.call(SCI_GETLINESTATE, job.firstLine - 1) : 0;
+
+    // End on a line start past from, so every job moves on.
+    Sci_Position end = length;
+    if (from + workerJobBytes < length) {
+        const Sci_Position lineStart = sci.call(SCI_POSITIONFROMLINE, sci.call(SCI_LINEFROMPOSITION, from + workerJobBytes));
+        if (lineStart > from) end = lineStart;
+    }
+
+    ScintillaDocumentView document(sci);
+    job.text.assign(document.range(job.startPos, end - job.startPos));
+    g_styleWorker.submit(g_idleStyling.bufferId, std::move(job));
+    g_idleStyling.lexing = true;
+}
+
+// Take the worker's result and commit it from the idle timer. The queue is
+// drained even when no result is wanted: the worker only wakes this thread
+// for a result that finds the queue empty.
+void receiveStyles()
+{
+    StyleResult& result = g_idleStyling.result;
+    if (!g_idleStyling.hScintilla || !result.committed()) {
+        StyleResult stale;
+        g_styleWorker.take(stale);
+        return;
+    }
+    if (!g_styleWorker.take(result)) return;
+    g_idleStyling.lexing = false;
+    if (!g_idleStyling.timer) g_idleStyling.timer = ::SetTimer(NULL, 0, USER_TIMER_MINIMUM, idleStylingTick);
+}
+
+// An edit to the document being styled cancels the job with the worker and
+// drops the result being committed. The timer is pushed back on every edit,
+// so the next job is only copied out once typing pauses.
+void supersedeStyling(const SCNotification* notifyCode)
+{
+    if (!g_idleStyling.hScintilla) return;
+    HWND hScintilla = (HWND)notifyCode->nmhdr.hwndFrom;
+    if (hScintilla != nppData._scintillaMainHandle && hScintilla != nppData._scintillaSecondHandle) return;
+    if (scintilla(hScintilla).call(SCI_GETDOCPOINTER) != g_idleStyling.document) return;
+
+    if (g_idleStyling.lexing) {
+        g_styleWorker.cancel();
+        g_idleStyling.lexing = false;
+    }
+    g_idleStyling.result.committedLines = g_idleStyling.result.out.lineStates.size();
+    g_idleStyling.timer = ::SetTimer(NULL, g_idleStyling.timer, editQuietMs, idleStylingTick);
+}
+
+// Jobs for the buffer left behind are cancelled; it gets new ones when it
+// is shown again.
+void bufferActivated(const SCNotification* notifyCode)
+{
+    const UINT_PTR bufferId = notifyCode->nmhdr.idFrom;
+    if (g_activeBuffer && g_activeBuffer != bufferId) {
+        g_scheduler.cancelBuffer(g_activeBuffer);
+        if (g_idleStyling.bufferId == g_activeBuffer) stopIdleStyling();
+    }
+    g_activeBuffer = bufferId;
+    g_scheduler.setActiveBuffer(bufferId);
+}
+
+void bufferClosed(const SCNotification* notifyCode)
+{
+    const UINT_PTR bufferId = notifyCode->nmhdr.idFrom;
+    g_scheduler.cancelBuffer(bufferId);
+    if (g_idleStyling.bufferId == bufferId) stopIdleStyling();
+    if (g_activeBuffer == bufferId) g_activeBuffer = 0;
+    g_bufferIndexes.erase(bufferId);
+    if (g_outline.bufferId == bufferId) {
+        ::SendMessage(g_outline.hList, LB_RESETCONTENT, 0, 0);
+        g_outline.bufferId = 0;
+        g_outline.current = -1;
+    }
+}
+
+// The indexes of the buffer on screen.
+BufferIndexes& currentIndexes()
+{
+    const UINT_PTR bufferId = (UINT_PTR)::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+    std::unique_ptr<BufferIndexes>& entry = g_bufferIndexes[bufferId];
+    if (!entry) {
+        entry = std::make_unique<BufferIndexes>();
+        entry->document = scintilla(getCurrentScintilla()).call(SCI_GETDOCPOINTER);
+    }
+    return *entry;
+}
+
+// The block tree of the buffer on screen, parsed on first use.
+std::shared_ptr<const BlockSnapshot> currentBlocks()
+{
+    BufferIndexes& indexes = currentIndexes();
+    if (!indexes.blocks) {
+        ScintillaDocumentView document(scintilla(getCurrentScintilla()));
+        indexes.blocks = std::make_unique<DocumentBlocks>();
+        indexes.blocks->reset(document);
+    }
+    return indexes.blocks->snapshot();
+}
+
+// The line starts of the buffer on screen, for code that maps lines and
+// positions off the UI thread. Indexed on first use.
+std::shared_ptr<const LineSnapshot> currentLines()
+{
+    BufferIndexes& indexes = currentIndexes();
+    if (!indexes.lines) {
+        ScintillaDocumentView document(scintilla(getCurrentScintilla()));
+        indexes.lines = std::make_unique<LineIndex>();
+        indexes.lines->reset(document);
+    }
+    return indexes.lines->snapshot();
+}
+
+// The headings of the buffer on screen, read from its block tree on first
+// use.
+const HeadingIndex& currentHeadings()
+{
+    currentBlocks();
+    BufferIndexes& indexes = currentIndexes();
+    if (!indexes.headings) {
+        ScintillaDocumentView document(scintilla(getCurrentScintilla()));
+        indexes.headings = std::make_unique<HeadingIndex>();
+        indexes.headings->reset(*indexes.blocks->snapshot(), document);
+    }
+    return *indexes.headings;
+}
+
+// Bring the indexes of an edited buffer up to date. Only the text around
+// the edit is read again.
+void updateIndexes(const SCNotification* notifyCode)
+{
+    if (g_bufferIndexes.empty()) return;
+    HWND hScintilla = (HWND)notifyCode->nmhdr.hwndFrom;
+    if (hScintilla != nppData._scintillaMainHandle && hScintilla != nppData._scintillaSecondHandle) return;
+
+    // Both views notify for a document open in both; only take one.
+    ScintillaCall& sci = scintilla(hScintilla);
+    const sptr_t documentPointer = sci.call(SCI_GETDOCPOINTER);
+    HWND hCurrent = getCurrentScintilla();
+    if (hScintilla != hCurrent && documentPointer == scintilla(hCurrent).call(SCI_GETDOCPOINTER)) return;
+
+    for (auto& entry : g_bufferIndexes) {
+        BufferIndexes& indexes = *entry.second;
+        if (indexes.document != documentPointer) continue;
+        TextEdit edit;
+        edit.position = notifyCode->position;
+        edit.removed = (notifyCode->modificationType & SC_MOD_DELETETEXT) ? notifyCode->length : 0;
+        edit.inserted = (notifyCode->modificationType & SC_MOD_INSERTTEXT) ? notifyCode->length : 0;
+        ScintillaDocumentView document(sci);
+        if (indexes.blocks) {
+            indexes.blocks->applyEdit(document, edit);
+            if (indexes.blocks->snapshot()->byteCount() != document.length()) {
+                // The tree no longer covers the document, so an edit was
+                // missed: parse it again, and the headings and outline too.
+                indexes.blocks->reset(document);
+                if (indexes.headings) {
+                    indexes.headings->reset(*indexes.blocks->snapshot(), document);
+                    if (g_outline.visible && entry.first == g_outline.bufferId) refreshOutline();
+                }
+            } else if (indexes.headings) {
+                const HeadingChange change =
+                    indexes.headings->applyChange(*indexes.blocks->snapshot(), indexes.blocks->lastChange(), document);
+                updateOutline(*indexes.headings, entry.first, change, sci);
+            }
+        }
+        if (indexes.lines) {
+            // Scintilla's own line count moved by linesAdded; anything else
+            // means an edit was missed, so index the document again.
+            const Sci_Position before = indexes.lines->snapshot()->lineCount();
+            indexes.lines->applyEdit(document, edit);
+            if (indexes.lines->snapshot()->lineCount() != before + notifyCode->linesAdded) indexes.lines->reset(document);
+        }
+        return;
+    }
+}
+
+// WM_TIMER is only delivered when the message queue is otherwise empty, so
+// each tick runs while the UI is idle.
+void CALLBACK idleStylingTick(HWND, UINT, UINT_PTR, DWORD)
+{
+    HWND hScintilla = g_idleStyling.hScintilla;
+    if (!hScintilla || scintilla(hScintilla).call(SCI_GETDOCPOINTER) != g_idleStyling.document) {
+        // The view shows another document now; its activation restarts this.
+        stopIdleStyling();
+        return;
+    }
+    if (!g_stylesEnabled || !hasMarkdownLexer(hScintilla)) {
+        // Another lexer owns the document now, and these styles are not its.
+        stopIdleStyling();
+        return;
+    }
+
+    ScintillaCall& sci = scintilla(hScintilla);
+    StyleResult& result = g_idleStyling.result;
+    if (result.committed()) {
+        // Nothing to commit: an edit has cancelled the last job and typing
+        // has paused since.
+        pauseIdleTimer();
+        if (!g_idleStyling.lexing) submitStyleJob(hScintilla, sci.call(SCI_GETENDSTYLED));
+        return;
+    }
+
+    if (result.version != g_documentVersion) {
+        // The text changed under the worker. Start again from wherever
+        // Scintilla's own styling has got to since.
+        result.committedLines = result.out.lineStates.size();
+        pauseIdleTimer();
+        submitStyleJob(hScintilla, sci.call(SCI_GETENDSTYLED));
+        return;
+    }
+
+    const ULONGLONG started = ::GetTickCount64();
+    while (!result.committed() && ::GetTickCount64() - started < idleSliceMs) {
+        commitStyleRun(sci, result, commitRunBytes);
+    }
+    if (!result.committed()) return;
+
+    LexerStyled styled;
+    styled.firstLine = result.firstLine;
+    styled.endLine = result.firstLine + static_cast<Sci_Position>(result.out.lineStates.size());
+    sci.call(SCI_PRIVATELEXERCALL, BETTERMD_CALL_STYLED, (sptr_t)&styled);
+
+    const Sci_Position end = result.startPos + static_cast<Sci_Position>(result.out.styles.size());
+    if (end >= sci.call(SCI_GETLENGTH)) {
+        stopIdleStyling();
+    } else {
+        pauseIdleTimer();
+        submitStyleJob(hScintilla, end);
+    }
+}
+
+double nowMs()
+{
+    static LARGE_INTEGER frequency = {};
+    if (!frequency.QuadPart) ::QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    ::QueryPerformanceCounter(&counter);
+    return counter.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+void postNotification(const SCNotification* notifyCode, PendingKind kind)
+{
+    if (!g_stylesEnabled) return;
+    if (g_notifications.post(notifyCode->nmhdr.idFrom, kind, nowMs()) && !g_notificationTimer) {
+        g_notificationTimer = ::SetTimer(NULL, 0, USER_TIMER_MINIMUM, notificationTick);
+    }
+}
+
+void stopNotificationTimer()
+{
+    if (g_notificationTimer) ::KillTimer(NULL, g_notificationTimer);
+    g_notificationTimer = 0;
+}
+
+void CALLBACK notificationTick(HWND, UINT, UINT_PTR, DWORD)
+{
+    stopNotificationTimer();
+
+    const UINT_PTR shown = (UINT_PTR)::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+    PendingBuffer pending;
+    if (!g_notifications.take(shown, pending)) return;
+    if (!g_stylesEnabled || !isMarkdownFile()) return;
+
+    applyMarkdownStyles();
+
+    // The latency is shown in the About box.
+    g_notifications.recordApplied(pending, nowMs());
+}
+
 void applyMarkdownStyles()
 {
     if (!isMarkdownFile()) return;
@@ -132,139 +775,22 @@ void applyMarkdownStyles()
     HWND hScintilla = getCurrentScintilla();
     if (!hScintilla) return;
 
-    // Enable Markdown lexer
-    ::SendMessage(hScintilla, SCI_SETLEXER, SCLEX_MARKDOWN, 0);
+    // Enable Markdown lexer. Notepad++ resets the styles whenever it puts
+    // its own lexer back, so whatever was recorded for the view is gone.
+    ViewStyles* view = viewStylesFor(hScintilla);
+    if (installMarkdownLexer(hScintilla) && view) view->theme = nullptr;
 
     // Detect dark mode
-    COLORREF defaultBg = (COLORREF)::SendMessage(hScintilla, SCI_STYLEGETBACK, STYLE_DEFAULT, 0);
+    COLORREF defaultBg = (COLORREF)scintilla(hScintilla).call(SCI_STYLEGETBACK, STYLE_DEFAULT);
     int r = GetRValue(defaultBg);
     int g = GetGValue(defaultBg);
     int b = GetBValue(defaultBg);
     bool isDark = ((r + g + b) / 3) < 128;
 
-    // Theme-aware colors
-    COLORREF h1Color = isDark ? RGB(255, 105, 120) : RGB(220, 20, 60);      // Crimson Red
-    COLORREF h2Color = isDark ? RGB(100, 180, 255) : RGB(30, 144, 255);     // Dodger Blue
-    COLORREF h3Color = isDark ? RGB(100, 220, 130) : RGB(34, 139, 34);      // Forest Green
-    COLORREF h4Color = isDark ? RGB(255, 180, 80) : RGB(255, 140, 0);       // Dark Orange
-    COLORREF h5Color = isDark ? RGB(200, 130, 255) : RGB(138, 43, 226);     // Blue Violet
-    COLORREF h6Color = isDark ? RGB(255, 130, 90) : RGB(178, 34, 34);       // Firebrick
-
-    COLORREF codeColor = isDark ? RGB(255, 150, 200) : RGB(199, 37, 78);
-    COLORREF codeBg = isDark ? RGB(50, 50, 55) : RGB(245, 245, 248);
-
-    COLORREF quoteColor = isDark ? RGB(180, 180, 190) : RGB(100, 100, 110);
-    COLORREF quoteBg = isDark ? RGB(45, 45, 50) : RGB(250, 250, 245);
-
-    COLORREF linkColor = isDark ? RGB(100, 180, 255) : RGB(0, 102, 204);
-    COLORREF listColor = isDark ? RGB(120, 200, 255) : RGB(0, 120, 215);
-    COLORREF ruleColor = isDark ? RGB(120, 120, 130) : RGB(180, 180, 190);
-
-    COLORREF boldColor = isDark ? RGB(255, 130, 140) : RGB(200, 0, 20);
-    COLORREF italicColor = isDark ? RGB(130, 220, 150) : RGB(20, 140, 40);
-    COLORREF strikeColor = isDark ? RGB(140, 140, 150) : RGB(130, 130, 140);
-
-    // H1 - 24pt, Extra Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER1, 24);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER1, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER1, h1Color);
-
-    // H2 - 22pt, Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER2, 22);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER2, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER2, h2Color);
-
-    // H3 - 20pt, Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER3, 20);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER3, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER3, h3Color);
-
-    // H4 - 18pt, Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER4, 18);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER4, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER4, h4Color);
-
-    // H5 - 16pt, Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER5, 16);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER5, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER5, h5Color);
-
-    // H6 - 14pt, Bold
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HEADER6, 14);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HEADER6, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HEADER6, h6Color);
-
-    // Bold text (**text** or __text__)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_STRONG1, boldColor);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_STRONG1, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_STRONG2, boldColor);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_STRONG2, TRUE);
-
-    // Italic text (*text* or _text_)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_EM1, italicColor);
-    ::SendMessage(hScintilla, SCI_STYLESETITALIC, SCE_MARKDOWN_EM1, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_EM2, italicColor);
-    ::SendMessage(hScintilla, SCI_STYLESETITALIC, SCE_MARKDOWN_EM2, TRUE);
-
-    // Inline code (`code`)
-    ::SendMessage(hScintilla, SCI_STYLESETBACK, SCE_MARKDOWN_CODE, codeBg);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_CODE, codeColor);
-    ::SendMessage(hScintilla, SCI_STYLESETFONT, SCE_MARKDOWN_CODE, (LPARAM)"Consolas");
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_CODE, 10);
-
-    ::SendMessage(hScintilla, SCI_STYLESETBACK, SCE_MARKDOWN_CODE2, codeBg);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_CODE2, codeColor);
-    ::SendMessage(hScintilla, SCI_STYLESETFONT, SCE_MARKDOWN_CODE2, (LPARAM)"Consolas");
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_CODE2, 10);
-
-    // Code blocks (```code```)
-    ::SendMessage(hScintilla, SCI_STYLESETBACK, SCE_MARKDOWN_CODEBK, codeBg);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_CODEBK, isDark ? RGB(210, 210, 220) : RGB(70, 70, 80));
-    ::SendMessage(hScintilla, SCI_STYLESETFONT, SCE_MARKDOWN_CODEBK, (LPARAM)"Consolas");
-    ::SendMessage(hScintilla, SCI_STYLESETEOLFILLED, SCE_MARKDOWN_CODEBK, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_CODEBK, 10);
-
-    // Prechar (indented code blocks)
-    ::SendMessage(hScintilla, SCI_STYLESETBACK, SCE_MARKDOWN_PRECHAR, codeBg);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_PRECHAR, codeColor);
-    ::SendMessage(hScintilla, SCI_STYLESETFONT, SCE_MARKDOWN_PRECHAR, (LPARAM)"Consolas");
-
-    // Block quotes (> text)
-    ::SendMessage(hScintilla, SCI_STYLESETBACK, SCE_MARKDOWN_BLOCKQUOTE, quoteBg);
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_BLOCKQUOTE, quoteColor);
-    ::SendMessage(hScintilla, SCI_STYLESETITALIC, SCE_MARKDOWN_BLOCKQUOTE, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETEOLFILLED, SCE_MARKDOWN_BLOCKQUOTE, TRUE);
-
-    // Links [text](url)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_LINK, linkColor);
-    ::SendMessage(hScintilla, SCI_STYLESETUNDERLINE, SCE_MARKDOWN_LINK, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_LINK, FALSE);
-
-    // Horizontal rules (---, ***, ___)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_HRULE, ruleColor);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_HRULE, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_HRULE, 12);
-
-    // Unordered list items (-, *, +)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_ULIST_ITEM, listColor);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_ULIST_ITEM, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_ULIST_ITEM, 12);
-
-    // Ordered list items (1., 2., etc)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_OLIST_ITEM, listColor);
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_OLIST_ITEM, TRUE);
-    ::SendMessage(hScintilla, SCI_STYLESETSIZE, SCE_MARKDOWN_OLIST_ITEM, 12);
-
-    // Strikethrough (~~text~~)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_STRIKEOUT, strikeColor);
-    ::SendMessage(hScintilla, SCI_STYLESETITALIC, SCE_MARKDOWN_STRIKEOUT, TRUE);
-
-    // Line begin (# symbols themselves)
-    ::SendMessage(hScintilla, SCI_STYLESETFORE, SCE_MARKDOWN_LINE_BEGIN, isDark ? RGB(100, 100, 110) : RGB(160, 160, 170));
-    ::SendMessage(hScintilla, SCI_STYLESETBOLD, SCE_MARKDOWN_LINE_BEGIN, TRUE);
+    applyTheme(scintilla(hScintilla), view, isDark ? darkTheme : lightTheme);
 
     // Apply the styling
-    ::SendMessage(hScintilla, SCI_COLOURISE, 0, -1);
+    colouriseVisibleFirst(hScintilla);
 }
 
 void toggleStyles()
@@ -301,15 +827,636 @@ void resetStyles()
     HWND hScintilla = getCurrentScintilla();
     if (!hScintilla) return;
 
-    // Reset to default Notepad++ markdown styling
-    ::SendMessage(hScintilla, SCI_STYLECLEARALL, 0, 0);
-    ::SendMessage(hScintilla, SCI_SETLEXER, SCLEX_MARKDOWN, 0);
-    ::SendMessage(hScintilla, SCI_COLOURISE, 0, -1);
+    // Reset to default Notepad++ markdown styling. Setting the language again
+    // makes Notepad++ reinstall its own lexer and styles.
+    int langType = L_TEXT;
+    ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTLANGTYPE, 0, (LPARAM)&langType);
+    scintilla(hScintilla).call(SCI_STYLECLEARALL);
+    if (ViewStyles* view = viewStylesFor(hScintilla)) view->theme = nullptr;
+    ::SendMessage(nppData._nppHandle, NPPM_SETCURRENTLANGTYPE, 0, langType);
+    stopIdleStyling();
+    scintilla(hScintilla).call(SCI_COLOURISE, 0, -1);
+}
+
+// The list entry for a heading: its text, indented by level.
+std::wstring outlineEntry(const Heading& heading, ScintillaCall& sci)
+{
+    ScintillaDocumentView document(sci);
+    const Sci_Position start = sci.call(SCI_POSITIONFROMLINE, heading.line) + heading.textStart;
+    const std::string_view text = document.range(start, heading.textLength);
+    std::wstring entry(2 * (heading.level - 1), L' ');
+    const size_t indent = entry.size();
+    const int length = ::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+    if (length > 0) {
+        entry.resize(indent + length);
+        ::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &entry[indent], length);
+    }
+    return entry;
+}
+
+bool createOutlinePanel()
+{
+    WNDCLASSEX windowClass = {};
+    windowClass.cbSize = sizeof(windowClass);
+    windowClass.lpfnWndProc = outlineProc;
+    windowClass.hInstance = _gModule;
+    windowClass.lpszClassName = TEXT("BetterMdOutline");
+    ::RegisterClassEx(&windowClass);
+
+    g_outline.hPanel = ::CreateWindowEx(0, TEXT("BetterMdOutline"), TEXT("Outline"), WS_CHILD | WS_CLIPCHILDREN,
+                                        0, 0, 0, 0, nppData._nppHandle, NULL, _gModule, NULL);
+    if (!g_outline.hPanel) return false;
+    g_outline.hList = ::CreateWindowEx(0, TEXT("LISTBOX"), NULL,
+                                       WS_CHILD | WS_VISIBLE | WS_VSCROLL | LBS_NOTIFY | LBS_NOINTEGRALHEIGHT,
+                                       0, 0, 0, 0, g_outline.hPanel, NULL, _gModule, NULL);
+    ::SendMessage(g_outline.hList, WM_SETFONT, (WPARAM)::GetStockObject(DEFAULT_GUI_FONT), FALSE);
+
+    tTbData& dock = g_outline.dockData;
+    dock.hClient = g_outline.hPanel;
+    dock.pszName = TEXT("Markdown Outline");
+    dock.dlgID = outlineFuncIndex;
+    dock.uMask = DWS_DF_CONT_RIGHT;
+    dock.pszModuleName = g_moduleName;
+    ::SendMessage(nppData._nppHandle, NPPM_DMMREGASDCKDLG, 0, (LPARAM)&dock);
+    return true;
+}
+
+void toggleOutline()
+{
+    if (!g_outline.hPanel && !createOutlinePanel()) return;
+    g_outline.visible = !g_outline.visible;
+    ::SendMessage(nppData._nppHandle, g_outline.visible ? NPPM_DMMSHOW : NPPM_DMMHIDE, 0, (LPARAM)g_outline.hPanel);
+    ::SendMessage(nppData._nppHandle, NPPM_SETMENUITEMCHECK, funcItem[outlineFuncIndex]._cmdID, g_outline.visible);
+    refreshOutline();
+}
+
+// Fill the list from the buffer on screen, or empty it when that is not
+// Markdown.
+void refreshOutline()
+{
+    if (!g_outline.visible) return;
+    ::SendMessage(g_outline.hList, WM_SETREDRAW, FALSE, 0);
+    ::SendMessage(g_outline.hList, LB_RESETCONTENT, 0, 0);
+    g_outline.bufferId = 0;
+    g_outline.current = -1;
+    if (isMarkdownFile()) {
+        ScintillaCall& sci = scintilla(getCurrentScintilla());
+        for (const Heading& heading : currentHeadings().headings()) {
+            ::SendMessage(g_outline.hList, LB_ADDSTRING, 0, (LPARAM)outlineEntry(heading, sci).c_str());
+        }
+        g_outline.bufferId = (UINT_PTR)::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0);
+    }
+    ::SendMessage(g_outline.hList, WM_SETREDRAW, TRUE, 0);
+    ::InvalidateRect(g_outline.hList, NULL, TRUE);
+    updateOutlineSection();
+}
+
+// Replace the entries an edit changed, if the list shows that buffer.
+void updateOutline(const HeadingIndex& index, UINT_PTR bufferId, const HeadingChange& change, ScintillaCall& sci)
+{
+    if (!g_outline.visible || bufferId != g_outline.bufferId || (!change.removed && !change.inserted)) return;
+    ::SendMessage(g_outline.hList, WM_SETREDRAW, FALSE, 0);
+    for (size_t i = 0; i < change.removed; i++) ::SendMessage(g_outline.hList, LB_DELETESTRING, change.first, 0);
+    for (size_t i = change.first; i < change.first + change.inserted; i++) {
+        ::SendMessage(g_outline.hList, LB_INSERTSTRING, i, (LPARAM)outlineEntry(index.headings()[i], sci).c_str());
+    }
+    ::SendMessage(g_outline.hList, WM_SETREDRAW, TRUE, 0);
+    ::InvalidateRect(g_outline.hList, NULL, TRUE);
+    g_outline.current = -1;
+}
+
+// Select the heading whose section holds the caret. sectionAt() is a binary
+// search, so this is cheap enough for every SCN_UPDATEUI.
+void updateOutlineSection()
+{
+    if (!g_outline.visible || !g_outline.bufferId) return;
+    if ((UINT_PTR)::SendMessage(nppData._nppHandle, NPPM_GETCURRENTBUFFERID, 0, 0) != g_outline.bufferId) return;
+    const auto found = g_bufferIndexes.find(g_outline.bufferId);
+    if (found == g_bufferIndexes.end() || !found->second->headings) return;
+
+    ScintillaCall& sci = scintilla(getCurrentScintilla());
+    const Sci_Position line = sci.call(SCI_LINEFROMPOSITION, sci.call(SCI_GETCURRENTPOS));
+    const int section = found->second->headings->sectionAt((int)line);
+    if (section == g_outline.current) return;
+    g_outline.current = section;
+    ::SendMessage(g_outline.hList, LB_SETCURSEL, (WPARAM)section, 0);
+}
+
+// Scroll the heading of a list entry to the top of the view and put the
+// caret on it.
+void jumpToHeading(int index)
+{
+    const auto found = g_bufferIndexes.find(g_outline.bufferId);
+    if (found == g_bufferIndexes.end() || !found->second->headings) return;
+    const std::vector<Heading>& headings = found->second->headings->headings();
+    if (index < 0 || index >= (int)headings.size()) return;
+
+    ScintillaCall& sci = scintilla(getCurrentScintilla());
+    const Sci_Position line = headings[index].line;
+    sci.call(SCI_ENSUREVISIBLEENFORCEPOLICY, line);
+    sci.call(SCI_GOTOLINE, line);
+    sci.call(SCI_SETFIRSTVISIBLELINE, sci.call(SCI_VISIBLEFROMDOCLINE, line));
+    g_outline.current = index;
+}
+
+LRESULT CALLBACK outlineProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_SIZE:
+        if (g_outline.hList) ::MoveWindow(g_outline.hList, 0, 0, LOWORD(lParam), HIWORD(lParam), TRUE);
+        return 0;
+
+    // A click or a key moves the view; a double click also hands the focus
+    // back to the editor.
+    case WM_COMMAND:
+        if ((HWND)lParam == g_outline.hList && (HIWORD(wParam) == LBN_SELCHANGE || HIWORD(wParam) == LBN_DBLCLK)) {
+            jumpToHeading((int)::SendMessage(g_outline.hList, LB_GETCURSEL, 0, 0));
+            if (HIWORD(wParam) == LBN_DBLCLK) ::SetFocus(getCurrentScintilla());
+            return 0;
+        }
+        break;
+
+    // The panel's close button hides it.
+    case WM_NOTIFY: {
+        const NMHDR* header = (const NMHDR*)lParam;
+        if (header && header->hwndFrom == nppData._nppHandle && LOWORD(header->code) == DMN_CLOSE) {
+            g_outline.visible = false;
+            ::SendMessage(nppData._nppHandle, NPPM_SETMENUITEMCHECK, funcItem[outlineFuncIndex]._cmdID, FALSE);
+            return 0;
+        }
+        break;
+    }
+    }
+    return ::DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+// One index file per root, named from a hash of its path.
+std::filesystem::path workspaceIndexPath(const std::filesystem::path& root)
+{
+    TCHAR configDir[MAX_PATH] = {0};
+    ::SendMessage(nppData._nppHandle, NPPM_GETPLUGINSCONFIGDIR, MAX_PATH, (LPARAM)configDir);
+    wchar_t name[64];
+    swprintf(name, 64, L"workspace-%016llx.bmdx",
+             (unsigned long long)std::hash<std::wstring>()(root.lexically_normal().generic_wstring()));
+    return std::filesystem::path(configDir) / L"BetterMd" / name;
+}
+
+void indexWorkspace()
+{
+    requestWorkspaceScan();
+}
+
+// List the current directory and the Markdown files of the session again,
+// and index whatever changed.
+void requestWorkspaceScan()
+{
+    TCHAR directory[MAX_PATH] = {0};
+    ::SendMessage(nppData._nppHandle, NPPM_GETCURRENTDIRECTORY, MAX_PATH, (LPARAM)directory);
+    if (!directory[0]) return;
+
+    std::vector<std::filesystem::path> session;
+    const int count = (int)::SendMessage(nppData._nppHandle, NPPM_GETNBOPENFILES, 0, ALL_OPEN_FILES);
+    if (count > 0) {
+        std::vector<std::wstring> names(count, std::wstring(MAX_PATH, L'\0'));
+        std::vector<TCHAR*> pointers(count);
+        for (int i = 0; i < count; i++) pointers[i] = &names[i][0];
+        ::SendMessage(nppData._nppHandle, NPPM_GETOPENFILENAMES, (WPARAM)pointers.data(), count);
+        for (const std::wstring& name : names) {
+            const std::filesystem::path path(name.c_str());
+            if (path.is_absolute() && isMarkdownPath(path)) session.push_back(path);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        const std::filesystem::path root(directory);
+        if (root != g_workspace.root) {
+            g_workspace.root = root;
+            g_workspace.indexPath = workspaceIndexPath(root);
+        }
+        g_workspace.scan = true;
+        g_workspace.sessionFiles = std::move(session);
+    }
+    postWorkspaceRefresh();
+}
+
+// A saved Markdown file is indexed again on its own.
+void workspaceFileSaved(const SCNotification* notifyCode)
+{
+    TCHAR path[MAX_PATH] = {0};
+    ::SendMessage(nppData._nppHandle, NPPM_GETFULLPATHFROMBUFFERID, notifyCode->nmhdr.idFrom, (LPARAM)path);
+    if (!path[0] || !isMarkdownPath(path)) return;
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        if (g_workspace.root.empty()) return;
+        g_workspace.savedFiles.push_back(path);
+    }
+    postWorkspaceRefresh();
+}
+
+// A refresh posted while another runs supersedes it only in the scheduler:
+// the one running finishes, and the new one then takes what is left.
+void postWorkspaceRefresh()
+{
+    g_scheduler.post(0, JOB_INDEX, [](const CancelToken&) { refreshWorkspace(); });
+}
+
+void refreshWorkspace()
+{
+    std::lock_guard<std::mutex> running(g_workspace.refreshMutex);
+    std::shared_ptr<const WorkspaceIndex> index;
+    std::shared_ptr<const PathCompletion> paths;
+    std::filesystem::path root;
+    std::filesystem::path indexPath;
+    bool scan;
+    std::vector<std::filesystem::path> files;
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        index = g_workspace.index;
+        paths = g_workspace.paths;
+        root = g_workspace.root;
+        indexPath = g_workspace.indexPath;
+        scan = g_workspace.scan;
+        files.swap(scan ? g_workspace.sessionFiles : g_workspace.savedFiles);
+        g_workspace.scan = false;
+        if (scan) g_workspace.savedFiles.clear();
+    }
+    if (root.empty() || (!scan && files.empty())) return;
+
+    // Start from the file on disk when the root is new. Without one every
+    // file has to be listed.
+    if (!index || index->root() != root.lexically_normal().generic_u8string()) {
+        index = WorkspaceIndex::open(indexPath, root);
+        if (!index) scan = true;
+    }
+
+    const CancelToken& cancel = g_workspace.shutdown;
+    std::vector<WorkspaceSource> sources;
+    if (scan) sources = findMarkdownFiles(root, cancel);
+    for (const std::filesystem::path& file : files) {
+        WorkspaceSource source;
+        if (statSource(file, source)) sources.push_back(std::move(source));
+    }
+
+    WorkspaceBuild report;
+    std::shared_ptr<const WorkspaceIndex> next =
+        WorkspaceIndex::build(index, root, sources, scan, ThreadPool::background(), cancel, report);
+    if (!next) return;
+    if (next != index) next->save(indexPath);
+    if (!paths || &paths->index() != next.get()) paths = std::make_shared<PathCompletion>(next);
+
+    std::lock_guard<std::mutex> lock(g_workspace.mutex);
+    if (g_workspace.root == root) {
+        g_workspace.index = next;
+        g_workspace.paths = paths;
+        g_workspace.lastBuild = report;
+    }
+}
+
+std::wstring fromUtf8(std::string_view text)
+{
+    std::wstring wide;
+    const int length = ::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+    if (length > 0) {
+        wide.resize(length);
+        ::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &wide[0], length);
+    }
+    return wide;
+}
+
+bool createLinksPanel()
+{
+    WNDCLASSEX windowClass = {};
+    windowClass.cbSize = sizeof(windowClass);
+    windowClass.lpfnWndProc = linksProc;
+    windowClass.hInstance = _gModule;
+    windowClass.lpszClassName = TEXT("BetterMdLinks");
+    ::RegisterClassEx(&windowClass);
+
+    g_links.hPanel = ::CreateWindowEx(0, TEXT("BetterMdLinks"), TEXT("Links"), WS_CHILD | WS_CLIPCHILDREN,
+                                      0, 0, 0, 0, nppData._nppHandle, NULL, _gModule, NULL);
+    if (!g_links.hPanel) return false;
+    g_links.hList = ::CreateWindowEx(0, TEXT("LISTBOX"), NULL,
+                                     WS_CHILD | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL | LBS_NOTIFY | LBS_NOINTEGRALHEIGHT |
+                                         LBS_WANTKEYBOARDINPUT,
+                                     0, 0, 0, 0, g_links.hPanel, NULL, _gModule, NULL);
+    ::SendMessage(g_links.hList, WM_SETFONT, (WPARAM)::GetStockObject(DEFAULT_GUI_FONT), FALSE);
+    ::SendMessage(g_links.hList, LB_SETHORIZONTALEXTENT, 2000, 0);
+
+    tTbData& dock = g_links.dockData;
+    dock.hClient = g_links.hPanel;
+    dock.pszName = TEXT("Markdown Links");
+    dock.dlgID = linksFuncIndex;
+    dock.uMask = DWS_DF_CONT_BOTTOM;
+    dock.pszModuleName = g_moduleName;
+    ::SendMessage(nppData._nppHandle, NPPM_DMMREGASDCKDLG, 0, (LPARAM)&dock);
+    return true;
+}
+
+// Show the panel with a single line in place of the results.
+void showLinksPanel(const wchar_t* status)
+{
+    if (!g_links.hPanel && !createLinksPanel()) return;
+    if (!g_links.visible) {
+        g_links.visible = true;
+        ::SendMessage(nppData._nppHandle, NPPM_DMMSHOW, 0, (LPARAM)g_links.hPanel);
+    }
+    g_links.links.clear();
+    ::SendMessage(g_links.hList, LB_RESETCONTENT, 0, 0);
+    ::SendMessage(g_links.hList, LB_ADDSTRING, 0, (LPARAM)status);
+}
+
+// Check the links of the buffer on screen, as it is now rather than as
+// saved. The text is copied here and summarized in the job.
+void checkLinks()
+{
+    if (!isMarkdownFile()) {
+        showLinksPanel(L"Links are checked in Markdown files.");
+        return;
+    }
+    TCHAR pathName[MAX_PATH] = {0};
+    ::SendMessage(nppData._nppHandle, NPPM_GETFULLCURRENTPATH, MAX_PATH, (LPARAM)pathName);
+    const std::filesystem::path path(pathName);
+    if (!path.is_absolute()) {
+        showLinksPanel(L"Save the document to check its links.");
+        return;
+    }
+
+    ScintillaCall& sci = scintilla(getCurrentScintilla());
+    ScintillaDocumentView document(sci);
+    auto text = std::make_shared<std::string>(document.range(0, document.length()));
+    std::filesystem::path root;
+    std::shared_ptr<const WorkspaceIndex> index;
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        root = g_workspace.root;
+        index = g_workspace.index;
+    }
+    if (root.empty()) root = path.parent_path();
+    g_links.root = root;
+
+    showLinksPanel(L"Checking links…");
+    postLinkCheck([path, text, root, index](const CancelToken& cancel) {
+        MarkdownSummary summary;
+        summarizeMarkdown(*text, summary);
+        return g_linkChecker.checkDocument(path, summary, root, index.get(), ThreadPool::background(), cancel);
+    });
+}
+
+// Check every file of the workspace index, bringing the index up to date
+// first. With no workspace yet this starts the first scan, which the check
+// then waits for.
+void checkWorkspaceLinks()
+{
+    bool known;
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        known = !g_workspace.root.empty();
+    }
+    if (!known) requestWorkspaceScan();
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        g_links.root = g_workspace.root;
+    }
+
+    showLinksPanel(L"Checking the links of the workspace…");
+    postLinkCheck([](const CancelToken& cancel) {
+        refreshWorkspace();
+        std::shared_ptr<const WorkspaceIndex> index;
+        {
+            std::lock_guard<std::mutex> lock(g_workspace.mutex);
+            index = g_workspace.index;
+        }
+        if (!index) return std::vector<BrokenLink>();
+        return g_linkChecker.checkWorkspace(*index, ThreadPool::background(), cancel);
+    });
+}
+
+// Run a check in the background and wake the UI thread with its result.
+// A cancelled check hands nothing over.
+void postLinkCheck(std::function<std::vector<BrokenLink>(const CancelToken&)> check)
+{
+    g_scheduler.post(0, JOB_LINT, [check](const CancelToken& cancel) {
+        auto links = std::make_unique<std::vector<BrokenLink>>(check(cancel));
+        if (cancel.cancelled()) return;
+        {
+            std::lock_guard<std::mutex> lock(g_links.mutex);
+            g_links.pending = std::move(links);
+        }
+        ::PostMessage(nppData._nppHandle, NPPM_MSGTOPLUGIN, (WPARAM)g_moduleName, (LPARAM)&g_linksReady);
+    });
+}
+
+// Fill the list with the result of the last check, as
+// path:line:column problem: target.
+void receiveLinks()
+{
+    std::unique_ptr<std::vector<BrokenLink>> links;
+    {
+        std::lock_guard<std::mutex> lock(g_links.mutex);
+        links.swap(g_links.pending);
+    }
+    if (!links || !g_links.hList) return;
+
+    g_links.links = std::move(*links);
+    ::SendMessage(g_links.hList, WM_SETREDRAW, FALSE, 0);
+    ::SendMessage(g_links.hList, LB_RESETCONTENT, 0, 0);
+    for (const BrokenLink& link : g_links.links) {
+        char location[32];
+        snprintf(location, sizeof(location), ":%d:%d  ", link.line + 1, link.column + 1);
+        const std::string entry = WorkspaceIndex::relativePath(link.file, g_links.root) + location +
+                                  linkProblemName(link.problem) + ": " + link.target;
+        ::SendMessage(g_links.hList, LB_ADDSTRING, 0, (LPARAM)fromUtf8(entry).c_str());
+    }
+    if (g_links.links.empty()) ::SendMessage(g_links.hList, LB_ADDSTRING, 0, (LPARAM)L"No broken links.");
+    ::SendMessage(g_links.hList, WM_SETREDRAW, TRUE, 0);
+    ::InvalidateRect(g_links.hList, NULL, TRUE);
+}
+
+// Open the file of a list entry, or switch to it, and put the caret on the
+// link.
+void jumpToLink(int index)
+{
+    if (index < 0 || index >= (int)g_links.links.size()) return;
+    const BrokenLink& link = g_links.links[index];
+    if (!::SendMessage(nppData._nppHandle, NPPM_DOOPEN, 0, (LPARAM)link.file.c_str())) return;
+
+    ScintillaCall& sci = scintilla(getCurrentScintilla());
+    const Sci_Position position = sci.call(SCI_POSITIONFROMLINE, link.line) + link.column;
+    sci.call(SCI_ENSUREVISIBLEENFORCEPOLICY, link.line);
+    sci.call(SCI_GOTOPOS, position);
+}
+
+LRESULT CALLBACK linksProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    switch (message)
+    {
+    case WM_SIZE:
+        if (g_links.hList) ::MoveWindow(g_links.hList, 0, 0, LOWORD(lParam), HIWORD(lParam), TRUE);
+        return 0;
+
+    // A double click or Enter jumps; the focus goes to the editor so the
+    // link can be fixed straight away.
+    case WM_COMMAND:
+        if ((HWND)lParam == g_links.hList && HIWORD(wParam) == LBN_DBLCLK) {
+            jumpToLink((int)::SendMessage(g_links.hList, LB_GETCURSEL, 0, 0));
+            ::SetFocus(getCurrentScintilla());
+            return 0;
+        }
+        break;
+
+    // The list asks about each key because of LBS_WANTKEYBOARDINPUT; -2
+    // means Enter was handled, -1 leaves every other key to the list.
+    case WM_VKEYTOITEM:
+        if ((HWND)lParam == g_links.hList && LOWORD(wParam) == VK_RETURN) {
+            jumpToLink((int)HIWORD(wParam));
+            ::SetFocus(getCurrentScintilla());
+            return -2;
+        }
+        return -1;
+
+    // The panel's close button hides it.
+    case WM_NOTIFY: {
+        const NMHDR* header = (const NMHDR*)lParam;
+        if (header && header->hwndFrom == nppData._nppHandle && LOWORD(header->code) == DMN_CLOSE) {
+            g_links.visible = false;
+            return 0;
+        }
+        break;
+    }
+    }
+    return ::DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+// Show the completions for the text before the caret, or take down the
+// list shown for an earlier character once the caret has left the link.
+void completeLink(const SCNotification* notifyCode)
+{
+    HWND hScintilla = (HWND)notifyCode->nmhdr.hwndFrom;
+    if (hScintilla != getCurrentScintilla() || !isMarkdownFile()) return;
+    ScintillaCall& sci = scintilla(hScintilla);
+    const Sci_Position caret = sci.call(SCI_GETCURRENTPOS);
+    const Sci_Position lineStart = sci.call(SCI_POSITIONFROMLINE, sci.call(SCI_LINEFROMPOSITION, caret));
+    ScintillaDocumentView document(sci);
+    const std::string before(document.range(lineStart, caret - lineStart));
+
+    const LinkCompletionContext context = findLinkCompletion(before);
+    std::vector<std::string> items;
+    if (context.kind != COMPLETE_NONE) items = linkCompletions(context);
+    if (g_completion.showing && sci.call(SCI_AUTOCACTIVE)) sci.call(SCI_AUTOCCANCEL);
+    endLinkCompletion();
+    if (items.empty()) return;
+
+    std::string list;
+    for (const std::string& item : items) {
+        if (!list.empty()) list += '\n';
+        list += item;
+    }
+
+    // Entries may hold blanks, and the looser matches do not start with
+    // what was typed, so the list is split on new lines, kept in this order
+    // and not hidden when Scintilla finds no entry with the typed prefix.
+    g_completion.showing = true;
+    g_completion.hScintilla = hScintilla;
+    g_completion.autoHide = sci.call(SCI_AUTOCGETAUTOHIDE);
+    g_completion.ignoreCase = sci.call(SCI_AUTOCGETIGNORECASE);
+    const sptr_t separator = sci.call(SCI_AUTOCGETSEPARATOR);
+    const sptr_t order = sci.call(SCI_AUTOCGETORDER);
+    sci.call(SCI_AUTOCSETSEPARATOR, '\n');
+    sci.call(SCI_AUTOCSETORDER, SC_ORDER_CUSTOM);
+    sci.call(SCI_AUTOCSETAUTOHIDE, FALSE);
+    sci.call(SCI_AUTOCSETIGNORECASE, TRUE);
+    sci.call(SCI_AUTOCSHOW, context.typed.size(), (sptr_t)list.c_str());
+    sci.call(SCI_AUTOCSETSEPARATOR, separator);
+    sci.call(SCI_AUTOCSETORDER, order);
+}
+
+// The candidates for a context, from what is already indexed.
+std::vector<std::string> linkCompletions(const LinkCompletionContext& context)
+{
+    if (context.kind == COMPLETE_ANCHOR && context.path.empty()) {
+        std::vector<std::string> anchors;
+        std::map<std::string, int> repeats;
+        for (const Heading& heading : currentHeadings().headings()) {
+            if (heading.slug.empty()) continue;
+            const int repeat = repeats[heading.slug]++;
+            anchors.push_back(repeat ? heading.slug + "-" + std::to_string(repeat) : heading.slug);
+        }
+        return matchCompletions(anchors, context.typed, completionLimit);
+    }
+
+    std::shared_ptr<const PathCompletion> paths;
+    std::filesystem::path root;
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        paths = g_workspace.paths;
+        root = g_workspace.root;
+    }
+    if (!paths) return std::vector<std::string>();
+
+    // Links are completed relative to the document, which has to be in the
+    // workspace.
+    TCHAR pathName[MAX_PATH] = {0};
+    ::SendMessage(nppData._nppHandle, NPPM_GETFULLCURRENTPATH, MAX_PATH, (LPARAM)pathName);
+    const std::filesystem::path path(pathName);
+    if (!path.is_absolute()) return std::vector<std::string>();
+    const std::string file = WorkspaceIndex::relativePath(path, root);
+    if (file.compare(0, 3, "../") == 0 || std::filesystem::u8path(file).is_absolute()) return std::vector<std::string>();
+    const size_t slash = file.rfind('/');
+    const std::string directory = file.substr(0, (slash == std::string::npos) ? 0 : slash);
+
+    switch (context.kind) {
+    case COMPLETE_PATH:
+        return paths->complete(directory, context.typed, completionLimit);
+    case COMPLETE_ANCHOR:
+        return matchCompletions(paths->anchors(paths->findFile(directory, context.path)), context.typed,
+                                completionLimit);
+    case COMPLETE_LABEL:
+        return matchCompletions(paths->labels(paths->index().findFile(file)), context.typed, completionLimit);
+    default:
+        return std::vector<std::string>();
+    }
+}
+
+// Put back the settings a completion list replaced.
+void endLinkCompletion()
+{
+    if (!g_completion.showing) return;
+    g_completion.showing = false;
+    ScintillaCall& sci = scintilla(g_completion.hScintilla);
+    sci.call(SCI_AUTOCSETAUTOHIDE, g_completion.autoHide);
+    sci.call(SCI_AUTOCSETIGNORECASE, g_completion.ignoreCase);
 }
 
 void about()
 {
-    ::MessageBox(nppData._nppHandle,
+    // Time from buffer notifications to styled text in this session.
+    static const wchar_t* const kindNames[PENDING_KIND_COUNT] = { L"open", L"activate", L"save" };
+    std::wstring latency = L"\n\n⏱ Notification latency (avg / max):\n";
+    for (int kind = 0; kind < PENDING_KIND_COUNT; kind++) {
+        const LatencyStats& stats = g_notifications.latency(static_cast<PendingKind>(kind));
+        wchar_t line[96];
+        swprintf(line, 96, L"• %ls: %.1f / %.1f ms (%u)\n", kindNames[kind], stats.averageMs(), stats.maxMs, stats.count);
+        latency += line;
+    }
+    wchar_t merged[96];
+    swprintf(merged, 96, L"• merged: %u, skipped buffers: %u", g_notifications.coalesced(), g_notifications.dropped());
+    latency += merged;
+
+    // What the last refresh of the workspace index did.
+    {
+        std::lock_guard<std::mutex> lock(g_workspace.mutex);
+        if (g_workspace.index) {
+            const WorkspaceBuild& build = g_workspace.lastBuild;
+            wchar_t workspace[160];
+            swprintf(workspace, 160, L"\n\n🗂 Workspace index: %zu files\n• last refresh: %zu parsed, %zu unchanged, %zu removed",
+                     g_workspace.index->fileCount(), build.parsed, build.unchanged + build.touched, build.removed);
+            latency += workspace;
+        }
+    }
+
+    const std::wstring text = std::wstring(
         TEXT("Better Markdown Plugin v0.1\n\n")
         TEXT("Enhanced Markdown styling for Notepad++\n\n")
         TEXT("✨ Features:\n")
@@ -321,10 +1468,15 @@ void about()
         TEXT("• Underlined links with color\n")
         TEXT("• Larger, bold list markers\n")
         TEXT("• Enhanced horizontal rules\n")
+        TEXT("• Outline panel of the headings\n")
+        TEXT("• Workspace index of headings and links\n")
+        TEXT("• Broken link and anchor checks\n")
+        TEXT("• Completion of link targets, anchors and labels\n")
         TEXT("• Automatic dark mode detection\n\n")
         TEXT("📝 Supported: .md, .mkd, .markdown\n\n")
-        TEXT("Toggle styles from Plugins menu!"),
-        TEXT("About Better Markdown"), MB_OK | MB_ICONINFORMATION);
+        TEXT("Toggle styles from Plugins menu!")) + latency;
+
+    ::MessageBox(nppData._nppHandle, text.c_str(), TEXT("About Better Markdown"), MB_OK | MB_ICONINFORMATION);
 }
 
 extern "C" __declspec(dllexport) void setInfo(NppData notpadPlusData)
@@ -352,11 +1504,31 @@ extern "C" __declspec(dllexport) FuncItem* getFuncsArray(int* nbF)
     funcItem[1]._init2Check = false;
     funcItem[1]._pShKey = NULL;
 
-    lstrcpy(funcItem[2]._itemName, TEXT("About"));
-    funcItem[2]._pFunc = about;
+    lstrcpy(funcItem[2]._itemName, TEXT("Outline"));
+    funcItem[2]._pFunc = toggleOutline;
     funcItem[2]._init2Check = false;
     funcItem[2]._pShKey = NULL;
 
+    lstrcpy(funcItem[3]._itemName, TEXT("Index Workspace"));
+    funcItem[3]._pFunc = indexWorkspace;
+    funcItem[3]._init2Check = false;
+    funcItem[3]._pShKey = NULL;
+
+    lstrcpy(funcItem[4]._itemName, TEXT("Check Links"));
+    funcItem[4]._pFunc = checkLinks;
+    funcItem[4]._init2Check = false;
+    funcItem[4]._pShKey = NULL;
+
+    lstrcpy(funcItem[5]._itemName, TEXT("Check Workspace Links"));
+    funcItem[5]._pFunc = checkWorkspaceLinks;
+    funcItem[5]._init2Check = false;
+    funcItem[5]._pShKey = NULL;
+
+    lstrcpy(funcItem[6]._itemName, TEXT("About"));
+    funcItem[6]._pFunc = about;
+    funcItem[6]._init2Check = false;
+    funcItem[6]._pShKey = NULL;
+
     return funcItem;
 }
 
@@ -370,19 +1542,60 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification* notifyCode)
         commandMenuCleanUp();
         break;
 
-    case NPPN_BUFFERACTIVATED:
+    case NPPN_READY:
+        requestWorkspaceScan();
+        break;
+
+    // Auto-apply if enabled and it's a markdown file, once Notepad++ has
+    // finished with the buffer and the message queue is empty.
     case NPPN_FILEOPENED:
-        // Auto-apply if enabled and it's a markdown file
-        if (g_stylesEnabled && isMarkdownFile()) {
-            Sleep(100);
-            applyMarkdownStyles();
-        }
+        postNotification(notifyCode, PENDING_OPENED);
+        break;
+
+    case NPPN_BUFFERACTIVATED:
+        bufferActivated(notifyCode);
+        postNotification(notifyCode, PENDING_ACTIVATED);
+        refreshOutline();
+        break;
+
+    case NPPN_FILECLOSED:
+        bufferClosed(notifyCode);
         break;
 
     case NPPN_FILESAVED:
-        // Reapply after save if enabled
-        if (g_stylesEnabled && isMarkdownFile()) {
-            applyMarkdownStyles();
+        postNotification(notifyCode, PENDING_SAVED);
+        workspaceFileSaved(notifyCode);
+        break;
+
+    // The theme or the Style Configurator has rewritten the styles.
+    case NPPN_WORDSTYLESUPDATED:
+    case NPPN_DARKMODECHANGED:
+        invalidateViewStyles();
+        if (g_stylesEnabled && isMarkdownFile()) applyMarkdownStyles();
+        break;
+
+    case SCN_MODIFIED:
+        if (notifyCode->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) {
+            g_documentVersion++;
+            forwardEdit(notifyCode);
+            supersedeStyling(notifyCode);
+            updateIndexes(notifyCode);
+        }
+        break;
+
+    case SCN_CHARADDED:
+        completeLink(notifyCode);
+        break;
+
+    case SCN_AUTOCCOMPLETED:
+    case SCN_AUTOCCANCELLED:
+        endLinkCompletion();
+        break;
+
+    case SCN_UPDATEUI:
+        if ((notifyCode->updated & (SC_UPDATE_CONTENT | SC_UPDATE_SELECTION)) &&
+            (HWND)notifyCode->nmhdr.hwndFrom == getCurrentScintilla()) {
+            updateOutlineSection();
         }
         break;
 
@@ -393,9 +1606,41 @@ extern "C" __declspec(dllexport) void beNotified(SCNotification* notifyCode)
 
 extern "C" __declspec(dllexport) LRESULT messageProc(UINT Message, WPARAM wParam, LPARAM lParam)
 {
+    if (Message == NPPM_MSGTOPLUGIN && lParam) {
+        const CommunicationInfo* info = (const CommunicationInfo*)lParam;
+        if (info->internalMsg == BETTERMD_MSG_STYLES_READY) receiveStyles();
+        if (info->internalMsg == BETTERMD_MSG_LINKS_READY) receiveLinks();
+    }
     return TRUE;
 }
 
+// External lexer interface, so Notepad++ lists the lexer and loads its
+// style definitions from BetterMd.xml.
+extern "C" __declspec(dllexport) int __stdcall GetLexerCount()
+{
+    return 1;
+}
+
+extern "C" __declspec(dllexport) void __stdcall GetLexerName(unsigned int index, char* name, int buflength)
+{
+    if (index == 0 && buflength > 0) {
+        strncpy(name, BETTERMD_LEXER_NAME, buflength - 1);
+        name[buflength - 1] = '\0';
+    }
+}
+
+extern "C" __declspec(dllexport) void __stdcall GetLexerStatusText(unsigned int index, TCHAR* desc, int buflength)
+{
+    if (index == 0 && buflength > 0) {
+        lstrcpyn(desc, TEXT("Better Markdown"), buflength);
+    }
+}
+
+extern "C" __declspec(dllexport) void* __stdcall GetLexerFactory(unsigned int index)
+{
+    return (index == 0) ? (void*)MarkdownILexer::create : nullptr;
+}
+
 #ifdef UNICODE
 extern "C" __declspec(dllexport) BOOL isUnicode()
 {
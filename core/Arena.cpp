@@ -0,0 +1,121 @@
+#include "Arena.h"
+
+#include <cstdint>
+
+ChunkPool::~ChunkPool()
+{
+    for (std::vector<void*>& chunks : free_) {
+        for (void* chunk : chunks) ::operator delete(chunk);
+    }
+}
+
+ChunkPool& ChunkPool::shared()
+{
+    static ChunkPool pool;
+    return pool;
+}
+
+int ChunkPool::sizeClass(size_t size)
+{
+    int cls = 0;
+    while (cls + 1 < classCount && (minChunkBytes << cls) < size) cls++;
+    return cls;
+}
+
+void* ChunkPool::acquire(size_t& size)
+{
+    const int cls = sizeClass(size);
+    const size_t classBytes = minChunkBytes << cls;
+    if (classBytes >= size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_[cls].empty()) {
+            void* chunk = free_[cls].back();
+            free_[cls].pop_back();
+            pooled_ -= classBytes;
+            size = classBytes;
+            return chunk;
+        }
+        size = classBytes;
+    }
+    return ::operator new(size);
+}
+
+void ChunkPool::release(void* chunk, size_t size)
+{
+    const int cls = sizeClass(size);
+    if ((minChunkBytes << cls) == size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pooled_ + size <= keepBytes_) {
+            free_[cls].push_back(chunk);
+            pooled_ += size;
+            return;
+        }
+    }
+    ::operator delete(chunk);
+}
+
+size_t ChunkPool::pooledBytes()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pooled_;
+}
+
+void* Arena::allocate(size_t size, size_t align)
+{
+    if (!chunks_.empty()) {
+        const Chunk& chunk = chunks_[current_];
+        const uintptr_t at = reinterpret_cast<uintptr_t>(chunk.base) + offset_;
+        const size_t padding = (align - at % align) % align;
+        if (offset_ + padding + size <= chunk.size) {
+            offset_ += padding + size;
+            inUse_ += padding + size;
+            return chunk.base + offset_ - size;
+        }
+    }
+    nextChunk(size, align);
+    return allocate(size, align);
+}
+
+// Move on to the next kept chunk that fits, or get a new one, twice the size
+// of the last, from the pool. The space left in the chunk before is counted
+// as in use, since nothing else can go there until a reset.
+void Arena::nextChunk(size_t size, size_t align)
+{
+    const size_t needed = size + align;
+    if (!chunks_.empty()) {
+        inUse_ += chunks_[current_].size - offset_;
+        while (current_ + 1 < chunks_.size()) {
+            current_++;
+            offset_ = 0;
+            if (chunks_[current_].size >= needed) return;
+            inUse_ += chunks_[current_].size;
+        }
+    }
+
+    size_t chunkSize = chunks_.empty() ? ChunkPool::minChunkBytes : chunks_.back().size * 2;
+    if (chunkSize > 16 * ChunkPool::minChunkBytes) chunkSize = 16 * ChunkPool::minChunkBytes;
+    if (chunkSize < needed) chunkSize = needed;
+
+    Chunk chunk;
+    chunk.base = static_cast<char*>(pool_.acquire(chunkSize));
+    chunk.size = chunkSize;
+    chunks_.push_back(chunk);
+    reserved_ += chunkSize;
+    current_ = chunks_.size() - 1;
+    offset_ = 0;
+}
+
+void Arena::reset()
+{
+    current_ = 0;
+    offset_ = 0;
+    inUse_ = 0;
+}
+
+void Arena::release()
+{
+    for (const Chunk& chunk : chunks_) pool_.release(chunk.base, chunk.size);
+    chunks_.clear();
+    reset();
+    reserved_ = 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Chunks of memory for arenas, kept by size class once an arena is done
+// with them, so reparsing a document, or parsing the next one, reuses them
+// instead of going back to the heap. Classes are powers of two from
+// minChunkBytes; larger requests are rounded up to a power of two too.
+class ChunkPool
+{
+public:
+    static const size_t minChunkBytes = 64 * 1024;
+    static const int classCount = 16;                   // up to 2 GB
+    static const size_t defaultKeepBytes = 32 * 1024 * 1024;
+
+    explicit ChunkPool(size_t keepBytes = defaultKeepBytes) : keepBytes_(keepBytes) {}
+    ~ChunkPool();
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    // A chunk of at least size bytes; size is set to its real size.
+    void* acquire(size_t& size);
+
+    // Take a chunk back. It is freed instead when the pool already holds
+    // keepBytes.
+    void release(void* chunk, size_t size);
+
+    // Bytes held by the pool, waiting to be reused.
+    size_t pooledBytes();
+
+    static ChunkPool& shared();
+
+private:
+    static int sizeClass(size_t size);
+
+    std::mutex mutex_;
+    std::vector<void*> free_[classCount];
+    size_t pooled_ = 0;
+    const size_t keepBytes_;
+};
+
+// A bump allocator for the nodes of one document's parse tree. Objects are
+// never freed one by one: reset() drops them all at once, in constant time,
+// and keeps the chunks for the next parse. Only trivially destructible
+// types can be made, since nothing runs their destructors.
+class Arena
+{
+public:
+    explicit Arena(ChunkPool& pool = ChunkPool::shared()) : pool_(pool) {}
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Forget every object. The chunks stay with the arena.
+    void reset();
+
+    // Forget every object and give the chunks back to the pool.
+    void release();
+
+    // Bytes handed out since the last reset, including alignment padding,
+    // and bytes of chunk memory the arena holds.
+    size_t bytesInUse() const { return inUse_; }
+    size_t bytesReserved() const { return reserved_; }
+
+private:
+    struct Chunk
+    {
+        char* base;
+        size_t size;
+    };
+
+    void nextChunk(size_t size, size_t align);
+
+    ChunkPool& pool_;
+    std::vector<Chunk> chunks_;
+    size_t current_ = 0;        // chunk being filled
+    size_t offset_ = 0;         // first free byte in it
+    size_t inUse_ = 0;
+    size_t reserved_ = 0;
+};
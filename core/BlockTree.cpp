@@ -0,0 +1,153 @@
+#include "BlockTree.h"
+#include "MarkdownStyles.h"
+
+#include <vector>
+
+namespace {
+
+// The kind of leaf a line belongs to, or BLOCK_DOCUMENT for a blank line.
+// An underline continues the setext heading on the line above.
+const BlockKind LEAF_BLANK = BLOCK_DOCUMENT;
+
+struct LineLeaf
+{
+    BlockKind kind = LEAF_BLANK;
+    int level = 0;
+    bool opens = false;         // starts a new block even after one of its kind
+    bool underline = false;
+};
+
+LineLeaf classifyLeaf(const LexOutput& lexed, size_t line, const BlockState& before, const BlockState& after)
+{
+    LineLeaf leaf;
+    const size_t begin = lexed.lines.starts[line];
+    const size_t end = (line + 1 < lexed.lines.count()) ? lexed.lines.starts[line + 1] : lexed.styles.size();
+    const bool blank = lineKind(lexed.lines.classes[line]) == LK_BLANK;
+
+    if (before.mode == MDMODE_FRONTMATTER || after.mode == MDMODE_FRONTMATTER) {
+        leaf.kind = BLOCK_FRONTMATTER;
+        return leaf;
+    }
+    if (before.mode == MDMODE_FENCE || after.mode == MDMODE_FENCE) {
+        leaf.kind = BLOCK_CODE;
+        leaf.level = (before.mode == MDMODE_FENCE) ? before.arg : after.arg;
+        leaf.opens = before.mode != MDMODE_FENCE;
+        return leaf;
+    }
+    if (after.mode == MDMODE_HTML || (before.mode == MDMODE_HTML && !blank)) {
+        leaf.kind = BLOCK_HTML;
+        leaf.opens = before.mode != MDMODE_HTML;
+        return leaf;
+    }
+    if (after.mode == MDMODE_TABLE) {
+        leaf.kind = BLOCK_TABLE;
+        leaf.opens = before.mode != MDMODE_TABLE;
+        return leaf;
+    }
+    if (blank) return leaf;
+
+    bool lineBegin = false;
+    for (size_t i = begin; i < end; i++) {
+        const int style = static_cast<unsigned char>(lexed.styles[i]);
+        if (style >= SCE_MARKDOWN_HEADER1 && style <= SCE_MARKDOWN_HEADER6) {
+            leaf.kind = BLOCK_HEADING;
+            leaf.level = style - SCE_MARKDOWN_HEADER1 + 1;
+            leaf.opens = true;
+            return leaf;
+        }
+        if (style == SCE_MARKDOWN_HRULE) {
+            leaf.kind = BLOCK_RULE;
+            leaf.opens = true;
+            return leaf;
+        }
+        if (style == SCE_MARKDOWN_PRECHAR) {
+            leaf.kind = BLOCK_CODE;
+            return leaf;
+        }
+        if (style == SCE_MARKDOWN_ULIST_ITEM || style == SCE_MARKDOWN_OLIST_ITEM) leaf.opens = true;
+        if (style == SCE_MARKDOWN_LINE_BEGIN) lineBegin = true;
+    }
+
+    leaf.kind = BLOCK_PARAGRAPH;
+    leaf.underline = before.paragraph && !after.paragraph && lineBegin;
+    return leaf;
+}
+
+}
+
+BlockNode* BlockTree::append(BlockNode* parent, BlockKind kind, int level, int line)
+{
+    BlockNode* node = arena_.make<BlockNode>();
+    node->kind = kind;
+    node->level = level;
+    node->firstLine = line;
+    node->lastLine = line;
+    node->firstChild = nullptr;
+    node->lastChild = nullptr;
+    node->next = nullptr;
+    if (parent) {
+        if (parent->lastChild) parent->lastChild->next = node;
+        else parent->firstChild = node;
+        parent->lastChild = node;
+    }
+    nodes_++;
+    return node;
+}
+
+void BlockTree::build(const LexOutput& lexed, int initialState)
+{
+    arena_.reset();
+    nodes_ = 0;
+    root_ = append(nullptr, BLOCK_DOCUMENT, 0, 0);
+
+    // Open containers, outermost first: the lexer only tracks quotes at the
+    // top level, so any quotes come before the lists.
+    std::vector<BlockNode*> open;
+    BlockNode* leaf = nullptr;
+    BlockState before = BlockState::unpack(initialState);
+    const size_t count = lexed.lineStates.size();
+    for (size_t i = 0; i < count; i++) {
+        const int line = static_cast<int>(i);
+        const BlockState after = BlockState::unpack(lexed.lineStates[i]);
+        const LineLeaf kind = classifyLeaf(lexed, i, before, after);
+        before = after;
+        if (kind.kind == LEAF_BLANK) {
+            leaf = nullptr;
+            continue;
+        }
+
+        const size_t depth = static_cast<size_t>(after.quoteDepth + after.listDepth);
+        size_t kept = 0;
+        while (kept < open.size() && kept < depth &&
+               open[kept]->kind == ((static_cast<int>(kept) < after.quoteDepth) ? BLOCK_QUOTE : BLOCK_LIST)) {
+            kept++;
+        }
+        if (kept < open.size() || kept < depth) leaf = nullptr;
+        open.resize(kept);
+        while (open.size() < depth) {
+            BlockNode* parent = open.empty() ? root_ : open.back();
+            const int index = static_cast<int>(open.size());
+            const bool quote = index < after.quoteDepth;
+            open.push_back(append(parent, quote ? BLOCK_QUOTE : BLOCK_LIST,
+                                  quote ? index + 1 : index - after.quoteDepth + 1, line));
+        }
+        for (BlockNode* container : open) container->lastLine = line;
+
+        const bool continues = leaf && leaf->lastLine == line - 1 &&
+            ((kind.underline && leaf->kind == BLOCK_HEADING) ||
+             (leaf->kind == kind.kind && leaf->level == kind.level && !kind.opens));
+        if (continues) {
+            leaf->lastLine = line;
+        } else {
+            leaf = append(open.empty() ? root_ : open.back(), kind.kind, kind.level, line);
+        }
+        root_->lastLine = line;
+    }
+}
+
+void BlockTree::clear()
+{
+    arena_.release();
+    root_ = nullptr;
+    nodes_ = 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Arena.h"
+#include "MarkdownLexer.h"
+
+enum BlockKind
+{
+    BLOCK_DOCUMENT,
+    BLOCK_QUOTE,            // level: nesting depth
+    BLOCK_LIST,             // level: nesting depth
+    BLOCK_PARAGRAPH,
+    BLOCK_HEADING,          // level: 1-6
+    BLOCK_CODE,             // level: fence length, 0 for indented code
+    BLOCK_HTML,
+    BLOCK_RULE,
+    BLOCK_FRONTMATTER,
+    BLOCK_TABLE
+};
+
+// A block and the lines it spans. Containers end on their last non-blank
+// line. Nodes live in the tree's arena and are linked, not owned.
+struct BlockNode
+{
+    BlockKind kind;
+    int level;
+    int firstLine;
+    int lastLine;
+    BlockNode* firstChild;
+    BlockNode* lastChild;
+    BlockNode* next;
+};
+
+// The block structure of a document, rebuilt from the lexer's output: the
+// line states give the containers, fences, HTML blocks, tables and front
+// matter, and the styles tell headings, rules and indented code from
+// paragraphs. Every rebuild resets the arena instead of freeing nodes one
+// by one.
+class BlockTree
+{
+public:
+    explicit BlockTree(ChunkPool& pool = ChunkPool::shared()) : arena_(pool) {}
+
+    // Rebuild from a lex of lines, numbered from 0. initialState is the
+    // state lexing started from.
+    void build(const LexOutput& lexed, int initialState = 0);
+
+    // Drop the tree and give its memory back to the pool.
+    void clear();
+
+    const BlockNode* root() const { return root_; }
+    size_t nodeCount() const { return nodes_; }
+    const Arena& arena() const { return arena_; }
+
+private:
+    BlockNode* append(BlockNode* parent, BlockKind kind, int level, int line);
+
+    Arena arena_;
+    BlockNode* root_ = nullptr;
+    size_t nodes_ = 0;
+};
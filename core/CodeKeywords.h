@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string_view>
+
+// The keyword sets of the languages CodeLexer highlights, each hashed into a
+// KeywordTable there. SQL's are lower case and looked up without regard to
+// case. They are kept here so tools/keywordtables can find the table
+// multipliers, and tools/keywordbench can time the lookups.
+
+inline constexpr std::string_view cKeywords[] = {
+    "alignas", "alignof", "auto", "bool", "break", "case", "catch", "char", "class", "const",
+    "const_cast", "constexpr", "continue", "decltype", "default", "delete", "do", "double",
+    "dynamic_cast", "else", "enum", "explicit", "extern", "false", "final", "float", "for", "friend",
+    "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "nullptr",
+    "operator", "override", "private", "protected", "public", "register", "reinterpret_cast",
+    "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+    "switch", "template", "this", "throw", "true", "try", "typedef", "typename", "union", "unsigned",
+    "using", "virtual", "void", "volatile", "while",
+};
+
+inline constexpr std::string_view jsKeywords[] = {
+    "abstract", "any", "as", "async", "await", "boolean", "break", "case", "catch", "class", "const",
+    "constructor", "continue", "debugger", "declare", "default", "delete", "do", "else", "enum",
+    "export", "extends", "false", "finally", "for", "from", "function", "get", "if", "implements",
+    "import", "in", "instanceof", "interface", "keyof", "let", "new", "null", "number", "of",
+    "private", "protected", "public", "readonly", "return", "set", "static", "string", "super",
+    "switch", "this", "throw", "true", "try", "type", "typeof", "undefined", "var", "void", "while",
+    "with", "yield",
+};
+
+inline constexpr std::string_view pythonKeywords[] = {
+    "False", "None", "True", "and", "as", "assert", "async", "await", "break", "class", "continue",
+    "def", "del", "elif", "else", "except", "finally", "for", "from", "global", "if", "import", "in",
+    "is", "lambda", "nonlocal", "not", "or", "pass", "raise", "return", "self", "try", "while",
+    "with", "yield",
+};
+
+inline constexpr std::string_view jsonKeywords[] = {
+    "false", "null", "true",
+};
+
+inline constexpr std::string_view yamlKeywords[] = {
+    "false", "no", "null", "off", "on", "true", "yes",
+};
+
+inline constexpr std::string_view shellKeywords[] = {
+    "alias", "break", "case", "cd", "continue", "do", "done", "echo", "elif", "else", "esac", "eval",
+    "exec", "exit", "export", "fi", "for", "function", "if", "in", "local", "read", "return",
+    "select", "set", "shift", "source", "test", "then", "trap", "unset", "until", "while",
+};
+
+inline constexpr std::string_view sqlKeywords[] = {
+    "add", "all", "alter", "and", "as", "asc", "begin", "between", "by", "case", "check", "column",
+    "commit", "create", "cross", "database", "default", "delete", "desc", "distinct", "drop", "else",
+    "end", "exists", "foreign", "from", "full", "group", "having", "in", "index", "inner", "insert",
+    "into", "is", "join", "key", "left", "like", "limit", "not", "null", "offset", "on", "or",
+    "order", "outer", "primary", "references", "right", "rollback", "select", "set", "table",
+    "then", "to", "union", "unique", "update", "values", "view", "when", "where", "with",
+};
+
+// Info-string words. CodeLexer.cpp maps each to its language.
+inline constexpr std::string_view languageNames[] = {
+    "c", "h", "cpp", "c++", "cc", "cxx", "hpp",
+    "js", "javascript", "jsx", "mjs", "ts", "typescript", "tsx",
+    "py", "python", "python3",
+    "json", "jsonc",
+    "yaml", "yml",
+    "sh", "bash", "shell", "zsh", "console",
+    "sql",
+};
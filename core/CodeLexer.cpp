@@ -0,0 +1,318 @@
+#include "CodeLexer.h"
+#include "CodeKeywords.h"
+#include "KeywordTable.h"
+#include "MarkdownStyles.h"
+
+#include <cstring>
+
+namespace {
+
+// The keyword sets of CodeKeywords.h, with the multipliers
+// tools/keywordtables prints for them.
+constexpr KeywordTable cKeywordTable(cKeywords, 0x2953a6185807168bull);
+constexpr KeywordTable jsKeywordTable(jsKeywords, 0x799d03caf3fa5249ull);
+constexpr KeywordTable pythonKeywordTable(pythonKeywords, 0x144093704fadba5dull);
+constexpr KeywordTable jsonKeywordTable(jsonKeywords, 0x9af678222e728119ull);
+constexpr KeywordTable yamlKeywordTable(yamlKeywords, 0x14057b7ef767814full);
+constexpr KeywordTable shellKeywordTable(shellKeywords, 0x7252e9376e45641bull);
+constexpr KeywordTable sqlKeywordTable(sqlKeywords, 0x7ddafa57eaf43143ull);
+static_assert(cKeywordTable.perfect() && jsKeywordTable.perfect() && pythonKeywordTable.perfect() &&
+              jsonKeywordTable.perfect() && yamlKeywordTable.perfect() && shellKeywordTable.perfect() &&
+              sqlKeywordTable.perfect(), "a keyword set changed: run tools/keywordtables");
+
+// How a language's tokens look.
+struct CodeRules
+{
+    bool (*isKeyword)(std::string_view word);
+    const char* lineComment;    // null when there is none
+    bool blockComments;         // /* ... */
+    bool directives;            // # lines, as in C
+    bool tripleQuotes;          // """ and ''' strings
+    bool templateStrings;       // ` strings that can span lines
+    bool variables;             // $name and ${name}
+    bool ignoreCase;
+    bool keys;                  // a string before a colon is a key
+};
+
+template <const auto& table>
+bool inTable(std::string_view word)
+{
+    return table.contains(word);
+}
+
+const CodeRules rulesFor[] = {
+    { nullptr, nullptr, false, false, false, false, false, false, false },
+    { inTable<cKeywordTable>, "//", true, true, false, false, false, false, false },
+    { inTable<jsKeywordTable>, "//", true, false, false, true, false, false, false },
+    { inTable<pythonKeywordTable>, "#", false, false, true, false, false, false, false },
+    { inTable<jsonKeywordTable>, nullptr, false, false, false, false, false, false, true },
+    { inTable<yamlKeywordTable>, "#", false, false, false, false, false, false, false },
+    { inTable<shellKeywordTable>, "#", false, false, false, false, true, false, false },
+    { inTable<sqlKeywordTable>, "--", true, false, false, false, false, true, false },
+};
+
+// The language each of languageNames names.
+constexpr CodeLanguage namedLanguages[] = {
+    CODE_C, CODE_C, CODE_C, CODE_C, CODE_C, CODE_C, CODE_C,
+    CODE_JS, CODE_JS, CODE_JS, CODE_JS, CODE_JS, CODE_JS, CODE_JS,
+    CODE_PYTHON, CODE_PYTHON, CODE_PYTHON,
+    CODE_JSON, CODE_JSON,
+    CODE_YAML, CODE_YAML,
+    CODE_SHELL, CODE_SHELL, CODE_SHELL, CODE_SHELL, CODE_SHELL,
+    CODE_SQL,
+};
+static_assert(sizeof(languageNames) / sizeof(languageNames[0]) == sizeof(namedLanguages) / sizeof(namedLanguages[0]),
+              "one language per name");
+constexpr KeywordTable languageNameTable(languageNames, 0xe9bcd26890f095a5ull);
+static_assert(languageNameTable.perfect(), "a language name changed: run tools/keywordtables");
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isWordStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool isWordChar(char c)
+{
+    return isWordStart(c) || isDigit(c);
+}
+
+inline char toLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+void fill(char* styles, const char* base, const char* from, const char* to, char style)
+{
+    if (to > from) memset(styles + (from - base), style, to - from);
+}
+
+bool isKeyword(const CodeRules& rules, const char* p, const char* end)
+{
+    char lowered[24];
+    std::string_view word(p, end - p);
+    if (rules.ignoreCase) {
+        if (word.size() > sizeof(lowered)) return false;
+        for (size_t i = 0; i < word.size(); i++) lowered[i] = toLower(word[i]);
+        word = std::string_view(lowered, word.size());
+    }
+    return rules.isKeyword(word);
+}
+
+// The end of a string whose opening quote is at p, or end when it is not
+// closed on this line.
+const char* stringEnd(const char* p, const char* end, char quote)
+{
+    for (const char* q = p + 1; q < end; q++) {
+        if (*q == '\\') q++;
+        else if (*q == quote) return q + 1;
+    }
+    return end;
+}
+
+// Find delimiter in [p, end), skipping backslash escapes; returns the end of
+// the delimiter, or null.
+const char* findClosing(const char* p, const char* end, const char* delimiter)
+{
+    const size_t n = strlen(delimiter);
+    for (const char* q = p; q + n <= end; q++) {
+        if (*q == '\\') q++;
+        else if (memcmp(q, delimiter, n) == 0) return q + n;
+    }
+    return nullptr;
+}
+
+const char* numberEnd(const char* p, const char* end)
+{
+    while (p < end) {
+        if ((*p == 'e' || *p == 'E') && p + 1 < end && (p[1] == '+' || p[1] == '-')) p += 2;
+        else if (isWordChar(*p) || *p == '.') p++;
+        else break;
+    }
+    return p;
+}
+
+// A YAML line's key, "key:" at its start after any indentation and "- "
+// markers; returns the end of the key or null.
+const char* yamlKeyEnd(const char* p, const char* end)
+{
+    if (p >= end || *p == '#' || *p == '"' || *p == '\'' || *p == '{' || *p == '[') return nullptr;
+    for (const char* q = p; q < end; q++) {
+        if (*q == ':' && (q + 1 == end || isBlank(q[1]))) return q;
+        if (*q == '#' && q > p && isBlank(q[-1])) return nullptr;
+    }
+    return nullptr;
+}
+
+}
+
+CodeLanguage codeLanguage(const char* info, const char* end)
+{
+    while (info < end && isBlank(*info)) info++;
+    if (info < end && *info == '{') info++;         // ```{python}
+    if (info < end && *info == '.') info++;         // ```{.python}
+    const char* wordEnd = info;
+    while (wordEnd < end && !isBlank(*wordEnd) && *wordEnd != '{' && *wordEnd != '}' && *wordEnd != ',') wordEnd++;
+
+    char lowered[16];
+    const size_t n = wordEnd - info;
+    if (n == 0 || n > sizeof(lowered)) return CODE_NONE;
+    for (size_t i = 0; i < n; i++) lowered[i] = toLower(info[i]);
+    const int found = languageNameTable.find(std::string_view(lowered, n));
+    return (found >= 0) ? namedLanguages[found] : CODE_NONE;
+}
+
+int lexCodeLine(CodeLanguage language, int state, const char* begin, const char* end, const char* base,
+                char* styles)
+{
+    const CodeRules& rules = rulesFor[language];
+    const char* p = begin;
+
+    // Finish what the line before left open.
+    if (state == CODESTATE_COMMENT) {
+        const char* close = findClosing(p, end, "*/");
+        fill(styles, base, p, close ? close : end, SCE_MARKDOWN_CODE_COMMENT);
+        if (!close) return state;
+        p = close;
+        state = CODESTATE_NONE;
+    } else if (state == CODESTATE_STRING || state == CODESTATE_STRING2) {
+        const char* delimiter = (language == CODE_JS) ? "`" : (state == CODESTATE_STRING) ? "\"\"\"" : "'''";
+        const char* close = findClosing(p, end, delimiter);
+        fill(styles, base, p, close ? close : end, SCE_MARKDOWN_CODE_STRING);
+        if (!close) return state;
+        p = close;
+        state = CODESTATE_NONE;
+    }
+
+    const char* content = p;
+    while (content < end && isBlank(*content)) content++;
+    if (p == begin && rules.directives && content < end && *content == '#') {
+        fill(styles, base, content, end, SCE_MARKDOWN_CODE_PREPROC);
+        return CODESTATE_NONE;
+    }
+    if (language == CODE_YAML && p == begin) {
+        if (p + 3 <= end && (memcmp(p, "---", 3) == 0 || memcmp(p, "...", 3) == 0) &&
+            (p + 3 == end || isBlank(p[3]))) {
+            fill(styles, base, p, p + 3, SCE_MARKDOWN_CODE_PREPROC);
+            p += 3;
+        }
+        while (content + 1 < end && *content == '-' && isBlank(content[1])) {
+            content += 2;
+            while (content < end && isBlank(*content)) content++;
+        }
+        if (const char* keyEnd = yamlKeyEnd(content, end)) {
+            fill(styles, base, content, keyEnd, SCE_MARKDOWN_CODE_KEY);
+            p = keyEnd + 1;
+        }
+    }
+
+    while (p < end) {
+        const char c = *p;
+        const bool wordStart = (p == begin) || isBlank(p[-1]);
+
+        if (rules.lineComment) {
+            const size_t n = strlen(rules.lineComment);
+            if (p + n <= end && memcmp(p, rules.lineComment, n) == 0 && (rules.lineComment[0] != '#' || language == CODE_PYTHON || wordStart)) {
+                fill(styles, base, p, end, SCE_MARKDOWN_CODE_COMMENT);
+                return CODESTATE_NONE;
+            }
+        }
+
+        if (rules.blockComments && c == '/' && p + 1 < end && p[1] == '*') {
+            const char* close = findClosing(p + 2, end, "*/");
+            fill(styles, base, p, close ? close : end, SCE_MARKDOWN_CODE_COMMENT);
+            if (!close) return CODESTATE_COMMENT;
+            p = close;
+            continue;
+        }
+
+        if (rules.tripleQuotes && (c == '"' || c == '\'') && p + 2 < end && p[1] == c && p[2] == c) {
+            const char* close = findClosing(p + 3, end, (c == '"') ? "\"\"\"" : "'''");
+            fill(styles, base, p, close ? close : end, SCE_MARKDOWN_CODE_STRING);
+            if (!close) return (c == '"') ? CODESTATE_STRING : CODESTATE_STRING2;
+            p = close;
+            continue;
+        }
+
+        if (rules.templateStrings && c == '`') {
+            const char* close = findClosing(p + 1, end, "`");
+            fill(styles, base, p, close ? close : end, SCE_MARKDOWN_CODE_STRING);
+            if (!close) return CODESTATE_STRING;
+            p = close;
+            continue;
+        }
+
+        if (c == '"' || c == '\'') {
+            // An apostrophe inside a shell or YAML word is not a quote.
+            if (c == '\'' && !wordStart && (language == CODE_YAML || language == CODE_SHELL) && isWordChar(p[-1])) {
+                p++;
+                continue;
+            }
+            const char* close = (c == '\'' && language == CODE_SHELL) ? findClosing(p + 1, end, "'") : nullptr;
+            const char* stop = close ? close : stringEnd(p, end, c);
+            char style = SCE_MARKDOWN_CODE_STRING;
+            if (rules.keys) {
+                const char* q = stop;
+                while (q < end && isBlank(*q)) q++;
+                if (q < end && *q == ':') style = SCE_MARKDOWN_CODE_KEY;
+            }
+            fill(styles, base, p, stop, style);
+            p = stop;
+            continue;
+        }
+
+        if (rules.variables && c == '$' && p + 1 < end) {
+            const char* q = p + 1;
+            if (*q == '{') {
+                const char* close = static_cast<const char*>(memchr(q, '}', end - q));
+                q = close ? close + 1 : end;
+            } else if (isWordStart(*q)) {
+                while (q < end && isWordChar(*q)) q++;
+            } else {
+                q++;
+            }
+            fill(styles, base, p, q, SCE_MARKDOWN_CODE_PREPROC);
+            p = q;
+            continue;
+        }
+
+        if (language == CODE_YAML && (c == '&' || c == '*' || c == '!') && wordStart && p + 1 < end && !isBlank(p[1])) {
+            const char* q = p + 1;
+            while (q < end && !isBlank(*q)) q++;
+            fill(styles, base, p, q, SCE_MARKDOWN_CODE_PREPROC);
+            p = q;
+            continue;
+        }
+
+        if (isDigit(c) || ((c == '-' || c == '.') && p + 1 < end && isDigit(p[1]) && (p == begin || !isWordChar(p[-1])))) {
+            const char* q = numberEnd(p + 1, end);
+            fill(styles, base, p, q, SCE_MARKDOWN_CODE_NUMBER);
+            p = q;
+            continue;
+        }
+
+        if (isWordStart(c) || (c == '$' && language == CODE_JS)) {
+            const char* q = p + 1;
+            while (q < end && (isWordChar(*q) || (*q == '$' && language == CODE_JS))) q++;
+            // Shell and YAML words run on through dashes and dots, as in
+            // file names and values like yes-no.
+            const bool joined = (language == CODE_SHELL || language == CODE_YAML) && q < end && (*q == '-' || *q == '.');
+            if (!joined && isKeyword(rules, p, q)) fill(styles, base, p, q, SCE_MARKDOWN_CODE_KEYWORD);
+            while (joined && q < end && !isBlank(*q)) q++;
+            p = q;
+            continue;
+        }
+
+        p++;
+    }
+    return CODESTATE_NONE;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Languages the code in a fenced block is highlighted as. The value is kept
+// in the line state, so there are at most MDSTATE_LANGUAGE_MASK of them.
+enum CodeLanguage
+{
+    CODE_NONE,
+    CODE_C,         // C and C++
+    CODE_JS,        // JavaScript and TypeScript
+    CODE_PYTHON,
+    CODE_JSON,
+    CODE_YAML,
+    CODE_SHELL,
+    CODE_SQL
+};
+
+// What a line of code leaves open at its end.
+#define CODESTATE_NONE 0
+#define CODESTATE_COMMENT 1     // /* block comment
+#define CODESTATE_STRING 2      // """ string, or a ` template string
+#define CODESTATE_STRING2 3     // ''' string
+
+// The language a fence's info string names, from its first word.
+CodeLanguage codeLanguage(const char* info, const char* end);
+
+// Style the code in [begin, end), one line without its line ending, over
+// the CODEBK it already has. state is the CODESTATE_* the line before left
+// open; the one this line leaves open is returned.
+int lexCodeLine(CodeLanguage language, int state, const char* begin, const char* end, const char* base,
+                char* styles);
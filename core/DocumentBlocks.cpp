@@ -0,0 +1,252 @@
+#include "DocumentBlocks.h"
+
+#include <algorithm>
+
+namespace {
+
+// Walks the top-level blocks of a snapshot in order, keeping track of where
+// each one starts.
+class BlockCursor
+{
+public:
+    explicit BlockCursor(const BlockSnapshot& snapshot, const std::vector<std::shared_ptr<const BlockChunk>>& chunks)
+        : chunks_(chunks), total_(snapshot.blockCount()) {}
+
+    bool atEnd() const { return index_ >= total_; }
+    size_t index() const { return index_; }
+    Sci_Position start() const { return start_; }
+    const TopBlock& block() const { return *chunks_[chunk_]->blocks[offset_]; }
+
+    void next()
+    {
+        start_ += block().byteCount;
+        index_++;
+        if (++offset_ >= chunks_[chunk_]->blocks.size()) {
+            chunk_++;
+            offset_ = 0;
+        }
+    }
+
+    // Move to the block holding position, or the last block when position
+    // is the end of the document. Whole chunks are skipped at a time.
+    void seek(Sci_Position position)
+    {
+        while (chunk_ + 1 < chunks_.size() && start_ + remainingInChunk() <= position) {
+            start_ += remainingInChunk();
+            index_ += chunks_[chunk_]->blocks.size() - offset_;
+            chunk_++;
+            offset_ = 0;
+        }
+        while (index_ + 1 < total_ && start_ + block().byteCount <= position) next();
+    }
+
+private:
+    Sci_Position remainingInChunk() const
+    {
+        Sci_Position bytes = 0;
+        const std::vector<std::shared_ptr<const TopBlock>>& blocks = chunks_[chunk_]->blocks;
+        if (offset_ == 0) return chunks_[chunk_]->byteCount;
+        for (size_t i = offset_; i < blocks.size(); i++) bytes += blocks[i]->byteCount;
+        return bytes;
+    }
+
+    const std::vector<std::shared_ptr<const BlockChunk>>& chunks_;
+    size_t total_;
+    size_t chunk_ = 0;
+    size_t offset_ = 0;
+    size_t index_ = 0;
+    Sci_Position start_ = 0;
+};
+
+std::shared_ptr<const BlockChunk> makeChunk(std::vector<std::shared_ptr<const TopBlock>>::const_iterator begin,
+                                             std::vector<std::shared_ptr<const TopBlock>>::const_iterator end)
+{
+    std::shared_ptr<BlockChunk> chunk = std::make_shared<BlockChunk>();
+    chunk->blocks.assign(begin, end);
+    for (const std::shared_ptr<const TopBlock>& block : chunk->blocks) {
+        chunk->lineCount += block->lineCount;
+        chunk->byteCount += block->byteCount;
+    }
+    return chunk;
+}
+
+void appendNodes(const BlockNode* node, int base, std::vector<SpanBlock>& nodes)
+{
+    const size_t at = nodes.size();
+    SpanBlock span;
+    span.kind = node->kind;
+    span.level = node->level;
+    span.firstLine = node->firstLine - base;
+    span.lastLine = node->lastLine - base;
+    span.descendants = 0;
+    nodes.push_back(span);
+    for (const BlockNode* child = node->firstChild; child; child = child->next) appendNodes(child, base, nodes);
+    nodes[at].descendants = static_cast<int>(nodes.size() - at - 1);
+}
+
+}
+
+void DocumentBlocks::reset(DocumentView& document)
+{
+    const std::shared_ptr<const BlockSnapshot> previous = snapshot();
+    std::vector<std::shared_ptr<const TopBlock>> blocks;
+    lexWindow(document, 0, document.length(), 0, blocks);
+    publish(*previous, 0, previous->blockCount(), blocks);
+}
+
+void DocumentBlocks::applyEdit(DocumentView& document, const TextEdit& edit)
+{
+    const std::shared_ptr<const BlockSnapshot> previous = snapshot();
+    const BlockSnapshot& old = *previous;
+    if (old.blockCount() == 0) {
+        reset(document);
+        return;
+    }
+
+    // Start from the block before the one holding the line above the edit:
+    // the edit can turn that line into a setext underline or out of one,
+    // and the paragraph above it can then join or leave the block before.
+    BlockCursor cursor(old, old.chunks_);
+    cursor.seek(edit.position);
+    const size_t edited = cursor.index();
+    const std::string_view head = document.range(cursor.start(), edit.position - cursor.start());
+    const bool firstLine = head.find('\n') == std::string_view::npos;
+    BlockCursor above(old, old.chunks_);
+    if (edited > 0) above.seek(cursor.start() - 1);
+    BlockCursor from(old, old.chunks_);
+    if (firstLine && above.index() > 0) from.seek(above.start() - 1);
+    else from.seek(above.start());
+    const size_t first = from.index();
+    const Sci_Position start = from.start();
+    const int initialState = from.block().entryState;
+
+    // The first block that starts after the edit, in the old positions.
+    const Sci_Position delta = edit.inserted - edit.removed;
+    const Sci_Position editEnd = edit.position + edit.removed;
+    while (!cursor.atEnd() && cursor.start() <= editEnd) cursor.next();
+
+    // Lex through that block and check it still starts where and how it did;
+    // if so the rest of the old version is reused. Otherwise take in more
+    // blocks, twice as many each time, up to the end of the document.
+    std::vector<std::shared_ptr<const TopBlock>> blocks;
+    size_t extra = 1;
+    for (;;) {
+        if (cursor.atEnd()) {
+            lexWindow(document, start, document.length() - start, initialState, blocks);
+            publish(old, first, old.blockCount(), blocks);
+            return;
+        }
+
+        const Sci_Position target = cursor.start() + delta - start;
+        lexWindow(document, start, target + cursor.block().byteCount, initialState, blocks);
+        Sci_Position offset = 0;
+        size_t i = 0;
+        while (i < blocks.size() && offset < target) offset += blocks[i++]->byteCount;
+        if (offset == target && i < blocks.size() && blocks[i]->entryState == cursor.block().entryState) {
+            blocks.resize(i);
+            publish(old, first, cursor.index(), blocks);
+            return;
+        }
+
+        for (size_t n = 0; n < extra && !cursor.atEnd(); n++) cursor.next();
+        extra *= 2;
+    }
+}
+
+// Lex [start, start + length), which begins at the start of a top-level
+// block, and split it into top-level blocks.
+void DocumentBlocks::lexWindow(DocumentView& document, Sci_Position start, Sci_Position length, int initialState,
+                               std::vector<std::shared_ptr<const TopBlock>>& blocks)
+{
+    blocks.clear();
+    lastLexed_ = length;
+    if (length <= 0) return;
+
+    const std::string_view text = document.range(start, length);
+    lexMarkdown(text, initialState, start == 0, lexed_);
+    tree_.build(lexed_, initialState);
+
+    const LineTable& lines = lexed_.lines;
+    const int lineCount = static_cast<int>(lines.count());
+    auto lineStart = [&](int line) {
+        return (line < lineCount) ? static_cast<Sci_Position>(lines.starts[line]) : static_cast<Sci_Position>(text.size());
+    };
+
+    // Each block's span runs from its first line, or the window's start for
+    // the first one, to the next block's first line.
+    const BlockNode* node = tree_.root() ? tree_.root()->firstChild : nullptr;
+    int spanStart = 0;
+    do {
+        const BlockNode* following = node ? node->next : nullptr;
+        const int spanEnd = following ? following->firstLine : lineCount;
+
+        std::shared_ptr<TopBlock> block = std::make_shared<TopBlock>();
+        block->entryState = (spanStart > 0) ? lexed_.lineStates[spanStart - 1] : initialState;
+        block->lineCount = spanEnd - spanStart;
+        block->byteCount = lineStart(spanEnd) - lineStart(spanStart);
+        if (node) appendNodes(node, spanStart, block->nodes);
+        blocks.push_back(block);
+
+        spanStart = spanEnd;
+        node = following;
+    } while (node);
+}
+
+// Publish a version with blocks [first, last) of previous replaced. Only the
+// chunks holding those blocks are rebuilt.
+void DocumentBlocks::publish(const BlockSnapshot& previous, size_t first, size_t last,
+                             std::vector<std::shared_ptr<const TopBlock>>& replacement)
+{
+    const std::vector<std::shared_ptr<const BlockChunk>>& chunks = previous.chunks_;
+    std::shared_ptr<BlockSnapshot> next = std::make_shared<BlockSnapshot>();
+    BlockChange change;
+    change.firstBlock = first;
+    change.blockCount = replacement.size();
+    for (const std::shared_ptr<const TopBlock>& block : replacement) change.insertedLines += block->lineCount;
+
+    // Keep whole chunks before the first block replaced and after the last.
+    size_t chunk = 0;
+    size_t index = 0;
+    while (chunk < chunks.size() && index + chunks[chunk]->blocks.size() <= first) {
+        index += chunks[chunk]->blocks.size();
+        change.firstLine += chunks[chunk]->lineCount;
+        change.startPosition += chunks[chunk]->byteCount;
+        next->chunks_.push_back(chunks[chunk++]);
+    }
+
+    std::vector<std::shared_ptr<const TopBlock>> merged;
+    size_t endChunk = chunk;
+    size_t endIndex = index;
+    while (endChunk < chunks.size() && endIndex < std::max(last, first + 1)) {
+        endIndex += chunks[endChunk++]->blocks.size();
+    }
+    for (size_t c = chunk; c < endChunk; c++) {
+        for (size_t i = 0; i < chunks[c]->blocks.size(); i++, index++) {
+            const TopBlock& block = *chunks[c]->blocks[i];
+            if (index == first) merged.insert(merged.end(), replacement.begin(), replacement.end());
+            if (index < first || index >= last) merged.push_back(chunks[c]->blocks[i]);
+            if (index < first) {
+                change.firstLine += block.lineCount;
+                change.startPosition += block.byteCount;
+            } else if (index < last) {
+                change.removedLines += block.lineCount;
+            }
+        }
+    }
+    if (index <= first) merged.insert(merged.end(), replacement.begin(), replacement.end());
+
+    const size_t pieces = (merged.size() + BlockChunk::maxBlocks - 1) / BlockChunk::maxBlocks;
+    for (size_t p = 0; p < pieces; p++) {
+        next->chunks_.push_back(makeChunk(merged.begin() + merged.size() * p / pieces,
+                                          merged.begin() + merged.size() * (p + 1) / pieces));
+    }
+    next->chunks_.insert(next->chunks_.end(), chunks.begin() + endChunk, chunks.end());
+
+    for (const std::shared_ptr<const BlockChunk>& c : next->chunks_) {
+        next->blockCount_ += c->blocks.size();
+        next->lineCount_ += c->lineCount;
+        next->byteCount_ += c->byteCount;
+    }
+    lastChange_ = change;
+    std::atomic_store(&current_, std::shared_ptr<const BlockSnapshot>(next));
+}
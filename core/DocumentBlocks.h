@@ -0,0 +1,144 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "BlockTree.h"
+#include "DocumentView.h"
+#include "MarkdownLexer.h"
+
+// A block inside a top-level block, in preorder. Lines are counted from the
+// first line of the top-level block's span.
+struct SpanBlock
+{
+    BlockKind kind;
+    int level;
+    int firstLine;
+    int lastLine;
+    int descendants;        // nodes after this one that are inside it
+};
+
+// One top-level block, the blocks inside it and the blank lines after it,
+// immutable once published. Nothing in it is absolute, so a version of the
+// document with lines added above it shares it unchanged.
+struct TopBlock
+{
+    int entryState = 0;             // lexer state at the start of the span
+    int lineCount = 0;
+    Sci_Position byteCount = 0;
+    std::vector<SpanBlock> nodes;   // empty for a span of blank lines
+};
+
+// Up to maxBlocks consecutive top-level blocks.
+struct BlockChunk
+{
+    static const size_t maxBlocks = 64;
+
+    std::vector<std::shared_ptr<const TopBlock>> blocks;
+    int lineCount = 0;
+    Sci_Position byteCount = 0;
+};
+
+// One version of a document's block tree: a root of chunks of top-level
+// blocks. A new version copies the root and the chunks an edit touched and
+// shares every other chunk and block with the version before, so readers
+// can hold on to a snapshot while the next one is built.
+class BlockSnapshot
+{
+public:
+    size_t blockCount() const { return blockCount_; }
+    int lineCount() const { return lineCount_; }
+    Sci_Position byteCount() const { return byteCount_; }
+
+    // Call f(block, firstLine, startPosition) for every top-level block in
+    // document order.
+    template <typename F>
+    void forEach(F f) const
+    {
+        int line = 0;
+        Sci_Position position = 0;
+        for (const std::shared_ptr<const BlockChunk>& chunk : chunks_) {
+            for (const std::shared_ptr<const TopBlock>& block : chunk->blocks) {
+                f(*block, line, position);
+                line += block->lineCount;
+                position += block->byteCount;
+            }
+        }
+    }
+
+    // Call f(block, firstLine, startPosition) for count top-level blocks
+    // from block first on, which starts at line and position.
+    template <typename F>
+    void forEachFrom(size_t first, size_t count, int line, Sci_Position position, F f) const
+    {
+        size_t index = 0;
+        for (const std::shared_ptr<const BlockChunk>& chunk : chunks_) {
+            if (count == 0) return;
+            if (index + chunk->blocks.size() <= first) {
+                index += chunk->blocks.size();
+                continue;
+            }
+            for (size_t i = (first > index) ? first - index : 0; i < chunk->blocks.size() && count > 0; i++, count--) {
+                const TopBlock& block = *chunk->blocks[i];
+                f(block, line, position);
+                line += block.lineCount;
+                position += block.byteCount;
+            }
+            index += chunk->blocks.size();
+        }
+    }
+
+private:
+    friend class DocumentBlocks;
+
+    std::vector<std::shared_ptr<const BlockChunk>> chunks_;
+    size_t blockCount_ = 0;
+    int lineCount_ = 0;
+    Sci_Position byteCount_ = 0;
+};
+
+// The top-level blocks the last reset() or applyEdit() replaced, by where
+// they start and the lines they spanned before and after.
+struct BlockChange
+{
+    size_t firstBlock = 0;
+    size_t blockCount = 0;          // blocks in the new version
+    int firstLine = 0;
+    int removedLines = 0;
+    int insertedLines = 0;
+    Sci_Position startPosition = 0;
+};
+
+// Keeps the block tree of one document current across edits. An edit is
+// lexed from the top-level block before it until a later block starts in
+// the same place and state as before; only those blocks are rebuilt.
+class DocumentBlocks
+{
+public:
+    // Parse the whole document.
+    void reset(DocumentView& document);
+
+    // Update for an edit the document already holds.
+    void applyEdit(DocumentView& document, const TextEdit& edit);
+
+    // The current version. Safe to call from any thread.
+    std::shared_ptr<const BlockSnapshot> snapshot() const { return std::atomic_load(&current_); }
+
+    // Bytes lexed by the last reset() or applyEdit().
+    Sci_Position lastLexedBytes() const { return lastLexed_; }
+
+    // What the last reset() or applyEdit() changed.
+    const BlockChange& lastChange() const { return lastChange_; }
+
+private:
+    void lexWindow(DocumentView& document, Sci_Position start, Sci_Position length, int initialState,
+                   std::vector<std::shared_ptr<const TopBlock>>& blocks);
+    void publish(const BlockSnapshot& previous, size_t first, size_t last,
+                 std::vector<std::shared_ptr<const TopBlock>>& replacement);
+
+    std::shared_ptr<const BlockSnapshot> current_ = std::make_shared<BlockSnapshot>();
+    BlockTree tree_;
+    LexOutput lexed_;
+    Sci_Position lastLexed_ = 0;
+    BlockChange lastChange_;
+};
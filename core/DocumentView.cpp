@@ -0,0 +1,44 @@
+#include "DocumentView.h"
+
+namespace {
+
+// Clip [start, start + length) to a document of size total.
+void clip(Sci_Position total, Sci_Position& start, Sci_Position& length)
+{
+    if (start < 0) start = 0;
+    if (start > total) start = total;
+    if (length < 0 || length > total - start) length = total - start;
+}
+
+}
+
+std::string_view TextDocumentView::range(Sci_Position start, Sci_Position length)
+{
+    clip(this->length(), start, length);
+    return text_.substr(static_cast<size_t>(start), static_cast<size_t>(length));
+}
+
+Sci_Position ScintillaDocumentView::length() const
+{
+    return scintilla_.call(SCI_GETLENGTH);
+}
+
+std::string_view ScintillaDocumentView::range(Sci_Position start, Sci_Position length)
+{
+    clip(this->length(), start, length);
+    if (length == 0) return std::string_view();
+    const char* text = reinterpret_cast<const char*>(scintilla_.call(SCI_GETRANGEPOINTER, start, length));
+    return text ? std::string_view(text, static_cast<size_t>(length)) : std::string_view();
+}
+
+std::string_view LexerDocumentView::range(Sci_Position start, Sci_Position length)
+{
+    clip(this->length(), start, length);
+    if (length == 0) return std::string_view();
+    if (length >= directThreshold) {
+        return std::string_view(document_->BufferPointer() + start, static_cast<size_t>(length));
+    }
+    scratch_.resize(static_cast<size_t>(length));
+    document_->GetCharRange(&scratch_[0], start, length);
+    return scratch_;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "../plugin/ILexer.h"
+#include "ScintillaCall.h"
+
+// A position change reported by SCN_MODIFIED.
+struct TextEdit
+{
+    Sci_Position position;
+    Sci_Position removed;
+    Sci_Position inserted;
+};
+
+// Read access to a document's text without copying all of it. A view is
+// only valid until the next call or the next change to the document.
+class DocumentView
+{
+public:
+    virtual ~DocumentView() = default;
+
+    virtual Sci_Position length() const = 0;
+
+    // The text of [start, start + length), clipped to the document.
+    virtual std::string_view range(Sci_Position start, Sci_Position length) = 0;
+
+    std::string_view all() { return range(0, length()); }
+};
+
+// A document held in a plain buffer, as on Linux.
+class TextDocumentView : public DocumentView
+{
+public:
+    explicit TextDocumentView(std::string_view text) : text_(text) {}
+
+    Sci_Position length() const override { return static_cast<Sci_Position>(text_.size()); }
+    std::string_view range(Sci_Position start, Sci_Position length) override;
+
+private:
+    std::string_view text_;
+};
+
+// A document in a Scintilla view, read in place with SCI_GETRANGEPOINTER.
+// Scintilla keeps the text in a gap buffer and only closes the gap when it
+// falls inside the range asked for, which costs at most the length of the
+// range; the rest of the document is never moved. Must be used on the
+// view's thread.
+class ScintillaDocumentView : public DocumentView
+{
+public:
+    explicit ScintillaDocumentView(ScintillaCall& scintilla) : scintilla_(scintilla) {}
+
+    Sci_Position length() const override;
+    std::string_view range(Sci_Position start, Sci_Position length) override;
+
+private:
+    ScintillaCall& scintilla_;
+};
+
+// The document a lexer is given. IDocument can only hand out the whole
+// buffer, which moves the gap to the end, or copy a range, so ranges below
+// directThreshold are copied into scratch and larger ones, where moving
+// the gap once costs less than the copy, read from BufferPointer().
+class LexerDocumentView : public DocumentView
+{
+public:
+    static const Sci_Position directThreshold = 4 * 1024 * 1024;
+
+    LexerDocumentView(Scintilla::IDocument* document, std::string& scratch) : document_(document), scratch_(scratch) {}
+
+    Sci_Position length() const override { return document_->Length(); }
+    std::string_view range(Sci_Position start, Sci_Position length) override;
+
+private:
+    Scintilla::IDocument* document_;
+    std::string& scratch_;
+};
@@ -0,0 +1,169 @@
+#include "HeadingIndex.h"
+
+#include <algorithm>
+
+namespace {
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isLineEnd(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+// The end of the line starting at from, before its line end.
+size_t lineEndAt(std::string_view text, size_t from)
+{
+    while (from < text.size() && !isLineEnd(text[from])) from++;
+    return from;
+}
+
+// The start of the line after the one holding from.
+size_t nextLineAt(std::string_view text, size_t from)
+{
+    const size_t end = lineEndAt(text, from);
+    if (end + 1 < text.size() && text[end] == '\r' && text[end + 1] == '\n') return end + 2;
+    return (end < text.size()) ? end + 1 : end;
+}
+
+// The heading a top-level block starts with.
+Heading readHeading(const TopBlock& block, int line, Sci_Position position, DocumentView& document)
+{
+    const SpanBlock& node = block.nodes.front();
+    const std::string_view text = document.range(position, block.byteCount);
+    size_t begin = 0;
+    for (int i = 0; i < node.firstLine; i++) begin = nextLineAt(text, begin);
+    const std::pair<size_t, size_t> span = headingTextSpan(text, begin, node.lastLine - node.firstLine + 1);
+
+    Heading heading;
+    heading.line = line + node.firstLine;
+    heading.level = node.level;
+    heading.textStart = static_cast<int>(span.first - begin);
+    heading.textLength = static_cast<int>(span.second - span.first);
+    heading.slug = headingSlug(text.substr(span.first, span.second - span.first));
+    return heading;
+}
+
+void collectHeadings(const TopBlock& block, int line, Sci_Position position, DocumentView& document,
+                     std::vector<Heading>& headings)
+{
+    if (!block.nodes.empty() && block.nodes.front().kind == BLOCK_HEADING) {
+        headings.push_back(readHeading(block, line, position, document));
+    }
+}
+
+bool sameHeading(const Heading& a, const Heading& b)
+{
+    return a.level == b.level && a.textStart == b.textStart && a.textLength == b.textLength && a.slug == b.slug;
+}
+
+}
+
+// An ATX heading is one line; a setext heading is its text lines and the
+// underline.
+std::pair<size_t, size_t> headingTextSpan(std::string_view text, size_t begin, int lineCount)
+{
+    size_t end = lineEndAt(text, begin);
+    size_t p = begin;
+    while (p < end && isBlank(text[p])) p++;
+
+    if (lineCount <= 1) {
+        while (p < end && text[p] == '#') p++;
+        while (p < end && isBlank(text[p])) p++;
+        while (end > p && isBlank(text[end - 1])) end--;
+        size_t closing = end;
+        while (closing > p && text[closing - 1] == '#') closing--;
+        if (closing < end && (closing == p || isBlank(text[closing - 1]))) end = closing;
+    } else {
+        for (int i = 2; i < lineCount; i++) end = lineEndAt(text, nextLineAt(text, end));
+    }
+    while (end > p && isBlank(text[end - 1])) end--;
+    return { p, end };
+}
+
+// Lower case, spaces to dashes, and punctuation other than - and _
+// dropped. A link keeps only its text.
+std::string headingSlug(std::string_view text)
+{
+    std::string slug;
+    slug.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        const char c = text[i];
+        if (c == ']' && i + 1 < text.size() && text[i + 1] == '(') {
+            const size_t close = text.find(')', i + 2);
+            if (close != std::string_view::npos) {
+                i = close;
+                continue;
+            }
+        }
+        if (c >= 'A' && c <= 'Z') slug += static_cast<char>(c - 'A' + 'a');
+        else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_') slug += c;
+        else if (isBlank(c) || isLineEnd(c)) slug += '-';
+        else if (static_cast<unsigned char>(c) >= 0x80) slug += c;
+    }
+    return slug;
+}
+
+HeadingChange HeadingIndex::reset(const BlockSnapshot& blocks, DocumentView& document)
+{
+    std::vector<Heading> headings;
+    blocks.forEach([&](const TopBlock& block, int line, Sci_Position position) {
+        collectHeadings(block, line, position, document, headings);
+    });
+    return replace(0, headings_.size(), headings, 0);
+}
+
+HeadingChange HeadingIndex::applyChange(const BlockSnapshot& blocks, const BlockChange& change,
+                                        DocumentView& document)
+{
+    auto byLine = [](const Heading& heading, int line) { return heading.line < line; };
+    const size_t first = std::lower_bound(headings_.begin(), headings_.end(), change.firstLine, byLine) - headings_.begin();
+    const size_t last = std::lower_bound(headings_.begin() + first, headings_.end(),
+                                         change.firstLine + change.removedLines, byLine) - headings_.begin();
+
+    std::vector<Heading> headings;
+    blocks.forEachFrom(change.firstBlock, change.blockCount, change.firstLine, change.startPosition,
+                       [&](const TopBlock& block, int line, Sci_Position position) {
+                           collectHeadings(block, line, position, document, headings);
+                       });
+    return replace(first, last, headings, change.insertedLines - change.removedLines);
+}
+
+int HeadingIndex::sectionAt(int line) const
+{
+    auto byLine = [](int line, const Heading& heading) { return line < heading.line; };
+    return static_cast<int>(std::upper_bound(headings_.begin(), headings_.end(), line, byLine) - headings_.begin()) - 1;
+}
+
+// Replace headings [first, last) and move the ones after them by lineDelta.
+// The change reported leaves out headings at either end that are the same
+// as before.
+HeadingChange HeadingIndex::replace(size_t first, size_t last, std::vector<Heading>& replacement, int lineDelta)
+{
+    for (size_t i = last; i < headings_.size(); i++) headings_[i].line += lineDelta;
+
+    HeadingChange change;
+    size_t removed = last - first;
+    size_t inserted = replacement.size();
+    size_t same = 0;
+    while (same < removed && same < inserted && sameHeading(headings_[first + same], replacement[same])) same++;
+    while (removed > same && inserted > same && sameHeading(headings_[first + removed - 1], replacement[inserted - 1])) {
+        removed--;
+        inserted--;
+    }
+    change.first = first + same;
+    change.removed = removed - same;
+    change.inserted = inserted - same;
+
+    if (last - first == replacement.size()) {
+        std::move(replacement.begin(), replacement.end(), headings_.begin() + first);
+    } else {
+        headings_.erase(headings_.begin() + first, headings_.begin() + last);
+        headings_.insert(headings_.begin() + first, std::make_move_iterator(replacement.begin()),
+                         std::make_move_iterator(replacement.end()));
+    }
+    return change;
+}
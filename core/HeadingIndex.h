@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "DocumentBlocks.h"
+#include "DocumentView.h"
+
+// A top-level heading, ATX or setext.
+struct Heading
+{
+    int line;               // first line of the heading
+    int level;              // 1-6
+    int textStart;          // the heading text, from the start of the line,
+    int textLength;         // without the markers
+    std::string slug;       // GitHub-style anchor, without a -1, -2 suffix for repeats
+};
+
+// The text of a heading whose first line starts at begin in text, spanning
+// lineCount lines, without its markers or the blanks around it. Returns
+// offsets [first, second) into text.
+std::pair<size_t, size_t> headingTextSpan(std::string_view text, size_t begin, int lineCount);
+
+// GitHub's anchor for heading text, without the -1, -2 suffix for repeats.
+std::string headingSlug(std::string_view text);
+
+// The headings of an update: [first, first + removed) of the list before
+// became [first, first + inserted). Headings that only moved to another
+// line are not counted.
+struct HeadingChange
+{
+    size_t first = 0;
+    size_t removed = 0;
+    size_t inserted = 0;
+};
+
+// The top-level headings of one document in line order, kept current from
+// the blocks DocumentBlocks relexes for each edit. Only the headings in
+// those blocks are read again; the ones after them move by the lines added.
+class HeadingIndex
+{
+public:
+    // Index every heading of blocks.
+    HeadingChange reset(const BlockSnapshot& blocks, DocumentView& document);
+
+    // Update for the change blocks just made to the document.
+    HeadingChange applyChange(const BlockSnapshot& blocks, const BlockChange& change, DocumentView& document);
+
+    const std::vector<Heading>& headings() const { return headings_; }
+
+    // The heading whose section holds line, the last one at or above it, or
+    // -1 before the first heading.
+    int sectionAt(int line) const;
+
+private:
+    HeadingChange replace(size_t first, size_t last, std::vector<Heading>& replacement, int lineDelta);
+
+    std::vector<Heading> headings_;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a over the bytes of word.
+constexpr uint64_t keywordHash(std::string_view word)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (char c : word) h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    return h;
+}
+
+// Slots for count words: a power of two at least four times as many.
+constexpr int keywordTableBits(size_t count)
+{
+    int bits = 1;
+    while ((size_t(1) << bits) < count * 4) bits++;
+    return bits;
+}
+
+// A perfect hash over a fixed set of words, built at compile time. A word's
+// slot is the top bits of its hash times a multiplier that gives every word
+// its own slot. A lookup is then one hash, one multiply and at most one
+// comparison.
+//
+// Finding a multiplier takes thousands of tries for a larger set, more
+// than compilers allow a constant expression by default, so it is found
+// once by findMultiplier() (tools/keywordtables prints one for each set in
+// CodeKeywords.h) and passed in. A table built with a multiplier that sends
+// two words to one slot is not perfect(); static_assert that it is.
+template <size_t N>
+class KeywordTable
+{
+public:
+    static_assert(N > 0 && N < 255, "slots hold a byte-sized word index");
+
+    static constexpr int bits = keywordTableBits(N);
+    static constexpr size_t slotCount = size_t(1) << bits;
+
+    constexpr KeywordTable(const std::string_view (&words)[N], uint64_t multiplier)
+        : words_{}, slots_{}, multiplier_(multiplier), perfect_(place(words))
+    {
+    }
+
+    constexpr bool perfect() const { return perfect_; }
+    constexpr uint64_t multiplier() const { return multiplier_; }
+
+    // The index of word in the array the table was built from, or -1.
+    constexpr int find(std::string_view word) const
+    {
+        const unsigned char slot = slots_[slotOf(keywordHash(word))];
+        return (slot != emptySlot && words_[slot] == word) ? slot : -1;
+    }
+
+    constexpr bool contains(std::string_view word) const { return find(word) >= 0; }
+
+    // The first multiplier, in a fixed pseudo-random sequence, that gives
+    // every word its own slot. Meant to run outside the compiler.
+    static uint64_t findMultiplier(const std::string_view (&words)[N])
+    {
+        uint64_t seed = 0;
+        for (;;) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            if (KeywordTable(words, seed | 1).perfect()) return seed | 1;
+        }
+    }
+
+private:
+    static constexpr unsigned char emptySlot = 0xFF;
+
+    constexpr size_t slotOf(uint64_t hash) const { return static_cast<size_t>((hash * multiplier_) >> (64 - bits)); }
+
+    // Copy the words and fill their slots; false when two share one.
+    constexpr bool place(const std::string_view (&words)[N])
+    {
+        for (size_t s = 0; s < slotCount; s++) slots_[s] = emptySlot;
+        bool perfect = true;
+        for (size_t i = 0; i < N; i++) {
+            words_[i] = words[i];
+            unsigned char& slot = slots_[slotOf(keywordHash(words[i]))];
+            if (slot != emptySlot) perfect = false;
+            slot = static_cast<unsigned char>(i);
+        }
+        return perfect;
+    }
+
+    std::string_view words_[N];
+    unsigned char slots_[slotCount];
+    uint64_t multiplier_;
+    bool perfect_;
+};
@@ -0,0 +1,324 @@
+#include "LineClassifier.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BETTERMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics in any function; GCC and Clang need the
+// target enabled per function so the rest of the file stays SSE2-only.
+#if defined(__GNUC__) || defined(__clang__)
+#define BETTERMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BETTERMD_TARGET_AVX2
+#endif
+
+namespace {
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline int countTrailingZeros(uint32_t v)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, v);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+inline int popCount(uint32_t v)
+{
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+inline unsigned char makeClass(LineKind kind, int arg = 0)
+{
+    return static_cast<unsigned char>(kind | (arg << 4));
+}
+
+// Classify a line from its first non-blank character p.
+unsigned char classifyContent(const char* p, const char* end)
+{
+    const char c = *p;
+
+    if (c == '#') {
+        const char* q = p;
+        while (q < end && *q == '#') q++;
+        const int n = static_cast<int>(q - p);
+        if (n <= 6 && (q == end || isBlank(*q))) return makeClass(LK_ATX, n);
+        return makeClass(LK_TEXT);
+    }
+
+    if (c == '`' || c == '~') {
+        const char* q = p;
+        while (q < end && *q == c) q++;
+        if (q - p >= 3 && (c == '~' || !memchr(q, '`', end - q))) {
+            return makeClass(LK_FENCE, c == '~' ? 1 : 0);
+        }
+        return makeClass(LK_TEXT);
+    }
+
+    if (c == '>') return makeClass(LK_QUOTE);
+
+    if (c == '-' || c == '*' || c == '_') {
+        int count = 0;
+        const char* q = p;
+        for (; q < end; q++) {
+            if (*q == c) count++;
+            else if (!isBlank(*q)) break;
+        }
+        if (q == end && count >= 3) return makeClass(LK_HRULE);
+    }
+
+    if ((c == '-' || c == '*' || c == '+') && (p + 1 == end || isBlank(p[1]))) {
+        return makeClass(LK_ULIST);
+    }
+
+    if (isDigit(c)) {
+        const char* q = p;
+        while (q < end && isDigit(*q) && q - p < 9) q++;
+        if (q < end && (*q == '.' || *q == ')') && (q + 1 == end || isBlank(q[1]))) {
+            return makeClass(LK_OLIST);
+        }
+    }
+
+    return makeClass(LK_TEXT);
+}
+
+inline void addLineEnd(const char* text, size_t size, size_t pos, std::vector<uint32_t>& starts)
+{
+    // A CR directly followed by LF ends the line at the LF.
+    if (text[pos] == '\r' && pos + 1 < size && text[pos + 1] == '\n') return;
+    if (pos + 1 < size) starts.push_back(static_cast<uint32_t>(pos + 1));
+}
+
+void findLineStartsScalar(const char* text, size_t size, size_t from, std::vector<uint32_t>& starts)
+{
+    for (size_t i = from; i < size; i++) {
+        if (text[i] == '\n' || text[i] == '\r') addLineEnd(text, size, i, starts);
+    }
+}
+
+const char* contentEnd(const char* begin, const char* next)
+{
+    while (next > begin && (next[-1] == '\n' || next[-1] == '\r')) next--;
+    return next;
+}
+
+#ifdef BETTERMD_X86
+
+void findLineStartsSse2(const char* text, size_t size, std::vector<uint32_t>& starts)
+{
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr))));
+        for (; mask; mask &= mask - 1) addLineEnd(text, size, i + countTrailingZeros(mask), starts);
+    }
+    findLineStartsScalar(text, size, i, starts);
+}
+
+BETTERMD_TARGET_AVX2 void findLineStartsAvx2(const char* text, size_t size, std::vector<uint32_t>& starts)
+{
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        uint32_t mask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr))));
+        for (; mask; mask &= mask - 1) addLineEnd(text, size, i + countTrailingZeros(mask), starts);
+    }
+    findLineStartsScalar(text, size, i, starts);
+}
+
+// Classify a line from a 16-byte window at its start. Line starts rarely
+// need more than 16 bytes to classify, so the AVX2 path shares this and only
+// widens the newline scan, which touches every byte. Anything the window
+// cannot decide (tab indents, long runs, long rules) goes to the scalar code.
+unsigned char classifyLineSse2(const char* begin, const char* end, const char* limit)
+{
+    if (limit - begin < 16) return classifyLine(begin, end);
+
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const size_t len = static_cast<size_t>(end - begin);
+    const uint32_t inLine = (len >= 16) ? 0xFFFFu : ((1u << len) - 1);
+    auto eq = [&](char c) {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)))) & inLine;
+    };
+
+    const uint32_t tabs = eq('\t');
+    const uint32_t blanks = eq(' ') | tabs;
+    const int indent = countTrailingZeros(~blanks);
+    if (indent >= 16 || (tabs & ((1u << indent) - 1))) return classifyLine(begin, end);
+    if (static_cast<size_t>(indent) == len) return makeClass(LK_BLANK);
+    if (indent >= 4) return makeClass(LK_INDENT);
+
+    const char* p = begin + indent;
+    const char c = *p;
+    switch (c) {
+    case '#': {
+        const int n = countTrailingZeros(~(eq('#') >> indent));
+        if (indent + n >= 16) break;
+        if (n <= 6 && (p + n == end || isBlank(p[n]))) return makeClass(LK_ATX, n);
+        return makeClass(LK_TEXT);
+    }
+    case '`':
+    case '~': {
+        const int n = countTrailingZeros(~(eq(c) >> indent));
+        if (indent + n >= 16) break;
+        if (n >= 3 && (c == '~' || !memchr(p + n, '`', end - p - n))) {
+            return makeClass(LK_FENCE, c == '~' ? 1 : 0);
+        }
+        return makeClass(LK_TEXT);
+    }
+    case '-':
+    case '*':
+    case '_':
+        if (len <= 16) {
+            const uint32_t marks = eq(c);
+            if ((marks | blanks) == inLine && popCount(marks) >= 3) return makeClass(LK_HRULE);
+        } else {
+            break;
+        }
+        return classifyContent(p, end);
+    default:
+        return classifyContent(p, end);
+    }
+    return classifyLine(begin, end);
+}
+
+#endif
+
+void classifyAll(const char* text, size_t size, LineTable& out, SimdLevel level)
+{
+    const char* const limit = text + size;
+    const size_t count = out.starts.size();
+    out.classes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const char* begin = text + out.starts[i];
+        const char* next = (i + 1 < count) ? text + out.starts[i + 1] : limit;
+        const char* end = contentEnd(begin, next);
+#ifdef BETTERMD_X86
+        if (level != SIMD_SCALAR) {
+            out.classes[i] = classifyLineSse2(begin, end, limit);
+            continue;
+        }
+#endif
+        (void)level;
+        (void)limit;
+        out.classes[i] = classifyLine(begin, end);
+    }
+}
+
+}
+
+SimdLevel detectSimdLevel()
+{
+#ifdef BETTERMD_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+        if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6) return SIMD_AVX2;
+    }
+    return SIMD_SSE2;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? SIMD_AVX2 : SIMD_SSE2;
+#endif
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+unsigned char classifyLine(const char* begin, const char* end)
+{
+    const char* p = begin;
+    int indent = 0;
+    while (p < end && isBlank(*p)) {
+        indent = (*p == '\t') ? (indent + 4) & ~3 : indent + 1;
+        p++;
+    }
+    if (p == end) return makeClass(LK_BLANK);
+    if (indent >= 4) return makeClass(LK_INDENT);
+    return classifyContent(p, end);
+}
+
+void findLineStarts(std::string_view text, std::vector<uint32_t>& starts)
+{
+    static const SimdLevel level = detectSimdLevel();
+    switch (level) {
+#ifdef BETTERMD_X86
+    case SIMD_AVX2:
+        findLineStartsAvx2(text.data(), text.size(), starts);
+        break;
+    case SIMD_SSE2:
+        findLineStartsSse2(text.data(), text.size(), starts);
+        break;
+#endif
+    default:
+        findLineStartsScalar(text.data(), text.size(), 0, starts);
+        break;
+    }
+}
+
+void classifyLines(std::string_view text, LineTable& out)
+{
+    static const SimdLevel level = detectSimdLevel();
+    classifyLines(text, out, level);
+}
+
+void classifyLines(std::string_view text, LineTable& out, SimdLevel level)
+{
+    out.starts.clear();
+    out.classes.clear();
+    if (text.empty()) return;
+
+    const char* const data = text.data();
+    const size_t size = text.size();
+    out.starts.reserve(size / 32 + 1);
+    out.starts.push_back(0);
+
+    switch (level) {
+#ifdef BETTERMD_X86
+    case SIMD_AVX2:
+        findLineStartsAvx2(data, size, out.starts);
+        break;
+    case SIMD_SSE2:
+        findLineStartsSse2(data, size, out.starts);
+        break;
+#endif
+    default:
+        findLineStartsScalar(data, size, 0, out.starts);
+        break;
+    }
+
+    classifyAll(data, size, out, level);
+}
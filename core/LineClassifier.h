@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Block-level class of a line, as found by the pre-pass. The class byte keeps
+// the kind in the low nibble and a small argument in the high nibble.
+enum LineKind : unsigned char
+{
+    LK_BLANK,
+    LK_TEXT,
+    LK_ATX,        // argument: heading level 1-6
+    LK_FENCE,      // argument: 1 for a ~~~ fence, 0 for ```
+    LK_ULIST,
+    LK_OLIST,
+    LK_QUOTE,
+    LK_HRULE,
+    LK_INDENT      // four or more columns of indentation
+};
+
+inline LineKind lineKind(unsigned char cls)
+{
+    return static_cast<LineKind>(cls & 0x0F);
+}
+
+inline int lineArg(unsigned char cls)
+{
+    return cls >> 4;
+}
+
+// Line starts and classes for a block of text. Offsets are relative to the
+// start of the text, and only lines that start inside the text are listed.
+struct LineTable
+{
+    std::vector<uint32_t> starts;
+    std::vector<unsigned char> classes;
+
+    size_t count() const { return starts.size(); }
+};
+
+// Which vector unit classifyLines() uses; resolved once from CPUID.
+enum SimdLevel
+{
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2
+};
+
+SimdLevel detectSimdLevel();
+
+// Find the line starts in text and classify every line. The level defaults
+// to the best one the CPU supports.
+void classifyLines(std::string_view text, LineTable& out);
+void classifyLines(std::string_view text, LineTable& out, SimdLevel level);
+
+// Append the offset of every line start in text after the first. Lines end
+// at LF, CR or CRLF; a line ending at the very end of text starts no line.
+void findLineStarts(std::string_view text, std::vector<uint32_t>& starts);
+
+// Classify a single line; end is the end of its content, before the line ending.
+unsigned char classifyLine(const char* begin, const char* end);
@@ -0,0 +1,154 @@
+#include "LineIndex.h"
+#include "LineClassifier.h"
+
+#include <algorithm>
+
+namespace {
+
+// Text is scanned in pieces of at most this many bytes, so offsets within a
+// piece fit the 32-bit starts findLineStarts() produces.
+const Sci_Position scanPieceBytes = Sci_Position(1) << 30;
+
+inline bool isLineEnd(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+// Append the line starts in text after its first byte, offset by base. The
+// byte after each piece is scanned with it, so a CRLF split between two
+// pieces is still one line end.
+void scanLineStarts(std::string_view text, Sci_Position base, std::vector<uint32_t>& scratch,
+                    std::vector<Sci_Position>& starts)
+{
+    const Sci_Position size = static_cast<Sci_Position>(text.size());
+    for (Sci_Position piece = 0; piece < size; piece += scanPieceBytes) {
+        const Sci_Position end = std::min(size, piece + scanPieceBytes);
+        scratch.clear();
+        findLineStarts(text.substr(static_cast<size_t>(piece), static_cast<size_t>(std::min(size, end + 1) - piece)), scratch);
+        for (uint32_t start : scratch) {
+            if (start <= end - piece) starts.push_back(base + piece + start);
+        }
+    }
+}
+
+}
+
+Sci_Position LineSnapshot::lineStart(Sci_Position line) const
+{
+    if (line <= 0 || chunks_.empty()) return 0;
+    if (line >= lineCount_) return length_;
+    const size_t c = std::upper_bound(firstLines_.begin(), firstLines_.end(), line) - firstLines_.begin() - 1;
+    return firstPositions_[c] + chunks_[c]->starts[static_cast<size_t>(line - firstLines_[c])];
+}
+
+Sci_Position LineSnapshot::lineFromPosition(Sci_Position position) const
+{
+    if (position <= 0 || chunks_.empty()) return 0;
+    if (position > length_) position = length_;
+    const size_t c = std::upper_bound(firstPositions_.begin(), firstPositions_.end(), position) - firstPositions_.begin() - 1;
+    const std::vector<uint32_t>& starts = chunks_[c]->starts;
+    const uint32_t offset = static_cast<uint32_t>(position - firstPositions_[c]);
+    return firstLines_[c] + (std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1);
+}
+
+void LineIndex::reset(DocumentView& document)
+{
+    const Sci_Position length = document.length();
+    const std::string_view text = document.range(0, length);
+    std::vector<Sci_Position> starts(1, 0);
+    scanLineStarts(text, 0, scratch_, starts);
+
+    // A line end at the end of the document is followed by an empty line.
+    if (length > 0 && isLineEnd(text.back())) starts.push_back(length);
+    publish(LineSnapshot(), 0, 0, starts, length, length);
+}
+
+// Whether a position starts a line depends only on the byte before it and,
+// after a CR, the byte at it. So the edit can only change the line starts
+// in [position, position + removed] of the old text, which become the ones
+// in [position, position + inserted]; the chunks holding them and the line
+// before them are rebuilt, and every later start moves by the same amount.
+void LineIndex::applyEdit(DocumentView& document, const TextEdit& edit)
+{
+    const std::shared_ptr<const LineSnapshot> previous = snapshot();
+    const LineSnapshot& old = *previous;
+    if (old.chunks_.empty()) {
+        reset(document);
+        return;
+    }
+
+    const Sci_Position length = document.length();
+    const Sci_Position delta = edit.inserted - edit.removed;
+    const Sci_Position oldEnd = edit.position + edit.removed;
+    auto chunkOf = [&](Sci_Position position) {
+        return static_cast<size_t>(std::upper_bound(old.firstPositions_.begin(), old.firstPositions_.end(), position) -
+                                   old.firstPositions_.begin() - 1);
+    };
+    const size_t first = chunkOf(std::max<Sci_Position>(0, edit.position - 1));
+    const size_t last = chunkOf(std::min(oldEnd, old.length_));
+
+    std::vector<Sci_Position> starts;
+    for (size_t c = first; c <= last; c++) {
+        for (uint32_t offset : old.chunks_[c]->starts) {
+            const Sci_Position start = old.firstPositions_[c] + offset;
+            if (start == 0 || start < edit.position) starts.push_back(start);
+        }
+    }
+
+    // The byte on either side of the new text decides whether its ends
+    // start lines.
+    const Sci_Position scanFrom = std::max<Sci_Position>(0, edit.position - 1);
+    const Sci_Position scanTo = std::min(length, edit.position + edit.inserted + 1);
+    const std::string_view text = document.range(scanFrom, scanTo - scanFrom);
+    const size_t scanned = starts.size();
+    scanLineStarts(text, scanFrom, scratch_, starts);
+    if (scanTo == length && !text.empty() && isLineEnd(text.back())) starts.push_back(length);
+    starts.erase(std::remove_if(starts.begin() + scanned, starts.end(), [&](Sci_Position start) {
+        return start < std::max<Sci_Position>(1, edit.position) || start > edit.position + edit.inserted;
+    }), starts.end());
+
+    for (size_t c = first; c <= last; c++) {
+        for (uint32_t offset : old.chunks_[c]->starts) {
+            const Sci_Position start = old.firstPositions_[c] + offset;
+            if (start > oldEnd) starts.push_back(start + delta);
+        }
+    }
+
+    const Sci_Position end = old.firstPositions_[last] + old.chunks_[last]->byteCount + delta;
+    publish(old, first, last + 1, starts, end, length);
+}
+
+// Publish a version with chunks [first, last) of previous replaced by the
+// absolute line starts of [starts.front(), end).
+void LineIndex::publish(const LineSnapshot& previous, size_t first, size_t last,
+                        const std::vector<Sci_Position>& starts, Sci_Position end, Sci_Position length)
+{
+    std::shared_ptr<LineSnapshot> next = std::make_shared<LineSnapshot>();
+    next->chunks_.assign(previous.chunks_.begin(), previous.chunks_.begin() + first);
+
+    const size_t pieces = (starts.size() + LineChunk::maxLines - 1) / LineChunk::maxLines;
+    for (size_t p = 0; p < pieces; p++) {
+        const size_t from = starts.size() * p / pieces;
+        const size_t to = starts.size() * (p + 1) / pieces;
+        std::shared_ptr<LineChunk> chunk = std::make_shared<LineChunk>();
+        chunk->starts.reserve(to - from);
+        for (size_t i = from; i < to; i++) chunk->starts.push_back(static_cast<uint32_t>(starts[i] - starts[from]));
+        chunk->byteCount = ((to < starts.size()) ? starts[to] : end) - starts[from];
+        next->chunks_.push_back(chunk);
+    }
+    next->chunks_.insert(next->chunks_.end(), previous.chunks_.begin() + last, previous.chunks_.end());
+
+    Sci_Position line = 0;
+    Sci_Position position = 0;
+    next->firstLines_.reserve(next->chunks_.size());
+    next->firstPositions_.reserve(next->chunks_.size());
+    for (const std::shared_ptr<const LineChunk>& chunk : next->chunks_) {
+        next->firstLines_.push_back(line);
+        next->firstPositions_.push_back(position);
+        line += static_cast<Sci_Position>(chunk->starts.size());
+        position += chunk->byteCount;
+    }
+    next->lineCount_ = line;
+    next->length_ = length;
+    std::atomic_store(&current_, std::shared_ptr<const LineSnapshot>(next));
+}
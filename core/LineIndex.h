@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DocumentView.h"
+
+// Up to maxLines consecutive line starts, relative to the first of them.
+// Immutable once published.
+struct LineChunk
+{
+    static const size_t maxLines = 4096;
+
+    std::vector<uint32_t> starts;   // starts[0] is 0
+    Sci_Position byteCount = 0;     // up to the first line of the next chunk
+};
+
+// One version of a document's line starts. Lines end at LF, CR or CRLF,
+// as in Scintilla, so lines and positions agree with SCI_LINEFROMPOSITION
+// and SCI_POSITIONFROMLINE for the same text.
+class LineSnapshot
+{
+public:
+    Sci_Position lineCount() const { return lineCount_; }
+    Sci_Position length() const { return length_; }
+
+    // The start of line, or the document length past the last line.
+    Sci_Position lineStart(Sci_Position line) const;
+
+    // The line holding position; the last line for the document length.
+    Sci_Position lineFromPosition(Sci_Position position) const;
+
+private:
+    friend class LineIndex;
+
+    std::vector<std::shared_ptr<const LineChunk>> chunks_;
+    std::vector<Sci_Position> firstLines_;  // per chunk
+    std::vector<Sci_Position> firstPositions_;
+    Sci_Position lineCount_ = 1;
+    Sci_Position length_ = 0;
+};
+
+// Keeps the line starts of one document current across edits, so worker
+// threads can map between lines and positions without asking Scintilla.
+// An edit rescans only its own text and rebuilds the chunks it touched;
+// every other chunk is shared with the version before.
+class LineIndex
+{
+public:
+    // Index the whole document.
+    void reset(DocumentView& document);
+
+    // Update for an edit the document already holds.
+    void applyEdit(DocumentView& document, const TextEdit& edit);
+
+    // The current version. Safe to call from any thread.
+    std::shared_ptr<const LineSnapshot> snapshot() const { return std::atomic_load(&current_); }
+
+private:
+    void publish(const LineSnapshot& previous, size_t first, size_t last,
+                 const std::vector<Sci_Position>& starts, Sci_Position end, Sci_Position length);
+
+    std::shared_ptr<const LineSnapshot> current_ = std::make_shared<LineSnapshot>();
+    std::vector<uint32_t> scratch_;
+};
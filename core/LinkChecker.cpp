@@ -0,0 +1,421 @@
+#include "LinkChecker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Run body(i) for every i below count on pool. The tasks take indexes in
+// turn, so a slow directory or a large file does not hold up a fixed share
+// of the rest.
+template <typename Body>
+void parallelFor(ThreadPool& pool, size_t count, const Body& body)
+{
+    if (count == 0) return;
+    std::atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) body(i);
+    };
+    std::vector<std::function<void()>> tasks(std::min<size_t>(pool.concurrency(), count), work);
+    pool.run(tasks);
+}
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline char lowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string percentDecode(std::string_view text)
+{
+    if (text.find('%') == std::string_view::npos) return std::string(text);
+    std::string decoded;
+    decoded.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size() && hexValue(text[i + 1]) >= 0 && hexValue(text[i + 2]) >= 0) {
+            decoded += static_cast<char>(hexValue(text[i + 1]) * 16 + hexValue(text[i + 2]));
+            i += 2;
+        } else {
+            decoded += text[i];
+        }
+    }
+    return decoded;
+}
+
+// A scheme, as in https: or mailto:, or a network path. One letter before
+// the colon is a Windows drive instead.
+bool isExternal(std::string_view target)
+{
+    if (target.size() >= 2 && target[0] == '/' && target[1] == '/') return true;
+    size_t i = 0;
+    while (i < target.size() && ((target[i] >= 'a' && target[i] <= 'z') || (target[i] >= 'A' && target[i] <= 'Z') ||
+                                 (i > 0 && ((target[i] >= '0' && target[i] <= '9') || target[i] == '+' ||
+                                            target[i] == '.' || target[i] == '-')))) {
+        i++;
+    }
+    return i >= 2 && i < target.size() && target[i] == ':';
+}
+
+// The length of the root of a / separated path: / or a drive such as C:/.
+size_t rootLength(std::string_view path)
+{
+    if (!path.empty() && path[0] == '/') return 1;
+    if (path.size() >= 3 && path[1] == ':' && path[2] == '/') return 3;
+    return 0;
+}
+
+// relative resolved against the directory base, folding . and .. the way
+// lexically_normal() does. Both are / separated and base is already
+// normal. Done on strings because the path class takes several times as
+// long, and a workspace has a great many links.
+std::string joinPath(std::string_view base, std::string_view relative)
+{
+    std::string path(base);
+    const size_t root = rootLength(path);
+    size_t from = 0;
+    while (from <= relative.size()) {
+        size_t end = relative.find('/', from);
+        if (end == std::string_view::npos) end = relative.size();
+        const std::string_view segment = relative.substr(from, end - from);
+        from = end + 1;
+        if (segment.empty() || segment == ".") continue;
+        if (segment == "..") {
+            const size_t slash = path.rfind('/');
+            path.resize((slash == std::string::npos || slash < root) ? root : slash);
+            continue;
+        }
+        if (!path.empty() && path.back() != '/') path += '/';
+        path += segment;
+    }
+    return path;
+}
+
+// A directory as generic_u8string() gives it, without a trailing / unless
+// it is a root.
+std::string directoryString(const fs::path& directory)
+{
+    std::string path = directory.lexically_normal().generic_u8string();
+    while (path.size() > rootLength(path) && path.back() == '/') path.pop_back();
+    return path;
+}
+
+struct Target
+{
+    fs::path path;
+    std::string name;               // file name, as directory listings give it
+    bool exists = false;
+    bool wantsAnchors = false;
+    bool timed = false;             // the listing gave its time and size
+    int64_t modified = 0;
+    uint64_t size = 0;
+    std::shared_ptr<const std::vector<std::string>> anchors;
+};
+
+// What a local link asks for: a file, empty for the document itself, and
+// an anchor in it.
+struct Request
+{
+    size_t link;
+    std::string file;
+    std::string fragment;
+    Target* target;
+};
+
+std::shared_ptr<const std::vector<std::string>> sortedAnchors(std::vector<std::string> anchors)
+{
+    std::sort(anchors.begin(), anchors.end());
+    return std::make_shared<const std::vector<std::string>>(std::move(anchors));
+}
+
+bool readFile(const fs::path& path, std::string& text)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+}
+
+std::string normalizeLabel(std::string_view label)
+{
+    std::string normalized;
+    normalized.reserve(label.size());
+    bool blank = false;
+    for (char c : label) {
+        if (isBlank(c)) {
+            blank = !normalized.empty();
+            continue;
+        }
+        if (blank) normalized += ' ';
+        blank = false;
+        normalized += lowerAscii(c);
+    }
+    return normalized;
+}
+
+const char* linkProblemName(LinkProblem problem)
+{
+    switch (problem) {
+    case LINK_NO_FILE: return "no such file";
+    case LINK_NO_ANCHOR: return "no such anchor";
+    case LINK_NO_DEFINITION: return "undefined reference";
+    }
+    return "";
+}
+
+std::vector<BrokenLink> LinkChecker::checkWorkspace(const WorkspaceIndex& index, ThreadPool& pool,
+                                                    const CancelToken& cancel)
+{
+    const fs::path root = fs::u8path(index.root());
+    std::vector<Document> documents(index.fileCount());
+    parallelFor(pool, documents.size(), [&](size_t file) {
+        Document& document = documents[file];
+        document.path = root / fs::u8path(index.path(file));
+        for (const IndexLink& link : index.links(file)) {
+            document.links.push_back({ static_cast<int>(link.line), static_cast<int>(link.column),
+                                       static_cast<LinkKind>(link.kind), index.string(link.target) });
+        }
+        for (const IndexReference& reference : index.references(file)) {
+            document.links.push_back({ static_cast<int>(reference.line), 0, LINK_INLINE, index.string(reference.target) });
+            document.labels.push_back(normalizeLabel(index.string(reference.label)));
+        }
+        std::sort(document.labels.begin(), document.labels.end());
+        std::vector<std::string> anchors;
+        for (const IndexHeading& heading : index.headings(file)) anchors.emplace_back(index.string(heading.anchor));
+        document.anchors = sortedAnchors(std::move(anchors));
+    });
+    return check(documents, root, &index, pool, cancel);
+}
+
+std::vector<BrokenLink> LinkChecker::checkDocument(const fs::path& path, const MarkdownSummary& summary,
+                                                   const fs::path& root, const WorkspaceIndex* index,
+                                                   ThreadPool& pool, const CancelToken& cancel)
+{
+    std::vector<Document> documents(1);
+    Document& document = documents.front();
+    document.path = path;
+    for (const SummaryLink& link : summary.links) {
+        document.links.push_back({ link.line, link.column, link.kind, link.target });
+    }
+    for (const SummaryReference& reference : summary.references) {
+        document.links.push_back({ reference.line, 0, LINK_INLINE, reference.target });
+        document.labels.push_back(normalizeLabel(reference.label));
+    }
+    std::sort(document.labels.begin(), document.labels.end());
+    std::vector<std::string> anchors;
+    for (const SummaryHeading& heading : summary.headings) anchors.push_back(heading.anchor);
+    document.anchors = sortedAnchors(std::move(anchors));
+    return check(documents, root, index, pool, cancel);
+}
+
+std::vector<BrokenLink> LinkChecker::check(std::vector<Document>& documents, const fs::path& root,
+                                           const WorkspaceIndex* index, ThreadPool& pool, const CancelToken& cancel)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = LinkCheckStats();
+    stats_.documents = documents.size();
+    std::vector<std::vector<BrokenLink>> broken(documents.size());
+
+    // Resolve every local link to a file and an anchor. Reference links
+    // only need their label defined; the definition is checked as a link
+    // of its own.
+    const std::string rootDirectory = directoryString(root);
+    std::vector<std::vector<Request>> requests(documents.size());
+    parallelFor(pool, documents.size(), [&](size_t d) {
+        const Document& document = documents[d];
+        const std::string directory = directoryString(document.path.parent_path());
+        for (size_t l = 0; l < document.links.size(); l++) {
+            const Link& link = document.links[l];
+            if (link.kind == LINK_AUTOLINK) continue;
+            if (link.kind == LINK_REFERENCE) {
+                if (!std::binary_search(document.labels.begin(), document.labels.end(), normalizeLabel(link.target))) {
+                    broken[d].push_back({ document.path, link.line, link.column, LINK_NO_DEFINITION, std::string(link.target) });
+                }
+                continue;
+            }
+            if (link.target.empty() || isExternal(link.target)) continue;
+
+            const size_t hash = link.target.find('#');
+            std::string_view file = link.target.substr(0, hash);
+            file = file.substr(0, file.find('?'));
+            Request request = { l, std::string(), std::string(), nullptr };
+            if (hash != std::string_view::npos) {
+                request.fragment = percentDecode(link.target.substr(hash + 1));
+                for (char& c : request.fragment) c = lowerAscii(c);
+            }
+            if (file.empty() && request.fragment.empty()) continue;
+            if (!file.empty()) {
+                const std::string decoded = percentDecode(file);
+                request.file = joinPath((decoded[0] == '/') ? rootDirectory : directory, decoded);
+            }
+            requests[d].push_back(std::move(request));
+        }
+    });
+    if (cancel.cancelled()) return {};
+
+    // The distinct files asked for, by directory.
+    std::unordered_map<std::string, Target> targets;
+    std::unordered_map<std::string, std::vector<Target*>> byDirectory;
+    for (std::vector<Request>& list : requests) {
+        stats_.links += list.size();
+        for (Request& request : list) {
+            if (request.file.empty()) continue;
+            Target& target = targets[request.file];
+            request.target = &target;
+            if (target.path.empty()) {
+                const size_t slash = request.file.rfind('/');
+                const size_t split = (slash == std::string::npos) ? 0 : slash + 1;
+                target.path = fs::u8path(request.file);
+                target.name = request.file.substr(split);
+                byDirectory[request.file.substr(0, std::max(rootLength(request.file), slash))].push_back(&target);
+            }
+            if (!request.fragment.empty() && isMarkdownPath(target.path)) target.wantsAnchors = true;
+        }
+    }
+    for (const std::vector<BrokenLink>& list : broken) stats_.links += list.size();
+    stats_.targets = targets.size();
+    stats_.directories = byDirectory.size();
+
+    // List each directory once, unless the cache still has it and none of
+    // its files needs a time and size for its anchors. The listing gives
+    // those in the same sweep on Windows; elsewhere each is one stat, made
+    // here in parallel. A name the listing lacks is looked up on its own
+    // before it counts as missing, since file systems may match names
+    // without regard to case.
+    std::vector<std::pair<Listing*, const std::vector<Target*>*>> directories;
+    directories.reserve(byDirectory.size());
+    for (const auto& entry : byDirectory) directories.emplace_back(&listings_[entry.first], &entry.second);
+    std::atomic<size_t> listed(0);
+    parallelFor(pool, directories.size(), [&](size_t i) {
+        if (cancel.cancelled()) return;
+        Listing& listing = *directories[i].first;
+        const std::vector<Target*>& inDirectory = *directories[i].second;
+        const fs::path directory = inDirectory.front()->path.parent_path();
+        std::unordered_map<std::string, Target*> timed;
+        for (Target* target : inDirectory) {
+            if (target->wantsAnchors) timed[target->name] = target;
+        }
+        std::error_code error;
+        const int64_t modified = static_cast<int64_t>(fs::last_write_time(directory, error).time_since_epoch().count());
+        if (error) {
+            listing = Listing();
+        } else if (!listing.exists || listing.modified != modified || !timed.empty()) {
+            listing = Listing();
+            listing.exists = true;
+            listing.modified = modified;
+            for (fs::directory_iterator it(directory, error); !error && it != fs::directory_iterator(); it.increment(error)) {
+                std::string name = it->path().filename().u8string();
+                const auto found = timed.find(name);
+                if (found != timed.end()) {
+                    std::error_code entryError;
+                    Target& target = *found->second;
+                    target.modified = static_cast<int64_t>(it->last_write_time(entryError).time_since_epoch().count());
+                    target.size = it->file_size(entryError);
+                    target.timed = !entryError;
+                }
+                listing.names.insert(std::move(name));
+            }
+            listed++;
+        }
+        for (Target* target : inDirectory) {
+            std::error_code missing;
+            target->exists = listing.exists &&
+                             (listing.names.count(target->name) || target->name.empty() || fs::exists(target->path, missing));
+        }
+    });
+    stats_.directoriesListed = listed;
+    if (cancel.cancelled()) return {};
+
+    // The anchors of the Markdown files linked to with a #fragment: from
+    // the index when its entry is current, from the cache when the file is
+    // unchanged since, and otherwise from a parse.
+    std::vector<std::pair<Target*, Anchors*>> anchorTargets;
+    for (auto& entry : targets) {
+        Target& target = entry.second;
+        if (target.exists && target.wantsAnchors) anchorTargets.emplace_back(&target, &anchors_[entry.first]);
+    }
+    stats_.anchorFiles = anchorTargets.size();
+    const std::string indexRoot = index ? std::string(index->root()) : std::string();
+    std::atomic<size_t> parsed(0);
+    parallelFor(pool, anchorTargets.size(), [&](size_t i) {
+        if (cancel.cancelled()) return;
+        Target& target = *anchorTargets[i].first;
+        Anchors& cached = *anchorTargets[i].second;
+        WorkspaceSource source;
+        source.modified = target.modified;
+        source.size = target.size;
+        if (!target.timed && !statSource(target.path, source)) return;
+
+        if (index) {
+            const std::string key = target.path.generic_u8string();
+            const bool inRoot = key.size() > indexRoot.size() && key.compare(0, indexRoot.size(), indexRoot) == 0 &&
+                                key[indexRoot.size()] == '/';
+            const int file = index->findFile(inRoot ? std::string_view(key).substr(indexRoot.size() + 1)
+                                                    : WorkspaceIndex::relativePath(target.path, fs::u8path(indexRoot)));
+            if (file >= 0 && index->file(file).modified == source.modified && index->file(file).size == source.size) {
+                std::vector<std::string> anchors;
+                for (const IndexHeading& heading : index->headings(file)) anchors.emplace_back(index->string(heading.anchor));
+                target.anchors = sortedAnchors(std::move(anchors));
+                return;
+            }
+        }
+        if (!cached.anchors || cached.modified != source.modified || cached.size != source.size) {
+            static thread_local std::string text;
+            static thread_local MarkdownSummary summary;
+            if (!readFile(target.path, text)) return;
+            summarizeMarkdown(text, summary);
+            std::vector<std::string> anchors;
+            for (const SummaryHeading& heading : summary.headings) anchors.push_back(heading.anchor);
+            cached.anchors = sortedAnchors(std::move(anchors));
+            cached.modified = source.modified;
+            cached.size = source.size;
+            parsed++;
+        }
+        target.anchors = cached.anchors;
+    });
+    stats_.anchorsParsed = parsed;
+    if (cancel.cancelled()) return {};
+
+    std::vector<BrokenLink> result;
+    for (size_t d = 0; d < documents.size(); d++) {
+        const Document& document = documents[d];
+        for (const Request& request : requests[d]) {
+            const Link& link = document.links[request.link];
+            bool exists = true;
+            const std::vector<std::string>* anchors = document.anchors.get();
+            if (request.target) {
+                exists = request.target->exists;
+                anchors = request.target->anchors.get();
+            }
+            if (!exists) {
+                broken[d].push_back({ document.path, link.line, link.column, LINK_NO_FILE, std::string(link.target) });
+            } else if (!request.fragment.empty() && anchors &&
+                       !std::binary_search(anchors->begin(), anchors->end(), request.fragment)) {
+                broken[d].push_back({ document.path, link.line, link.column, LINK_NO_ANCHOR, std::string(link.target) });
+            }
+        }
+        std::sort(broken[d].begin(), broken[d].end(), [](const BrokenLink& a, const BrokenLink& b) {
+            return (a.line != b.line) ? a.line < b.line : a.column < b.column;
+        });
+        std::move(broken[d].begin(), broken[d].end(), std::back_inserter(result));
+    }
+    return result;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "MarkdownSummary.h"
+#include "TaskScheduler.h"
+#include "ThreadPool.h"
+#include "WorkspaceIndex.h"
+
+enum LinkProblem
+{
+    LINK_NO_FILE,           // nothing at the path
+    LINK_NO_ANCHOR,         // the Markdown file has no heading with that anchor
+    LINK_NO_DEFINITION      // a reference link whose label is never defined
+};
+
+struct BrokenLink
+{
+    std::filesystem::path file;
+    int line;
+    int column;
+    LinkProblem problem;
+    std::string target;
+};
+
+// What the last check did, and how much of it the cache saved.
+struct LinkCheckStats
+{
+    size_t documents = 0;
+    size_t links = 0;               // local links and reference uses looked at
+    size_t targets = 0;             // distinct files they point at
+    size_t directories = 0;         // distinct directories holding those
+    size_t directoriesListed = 0;   // the rest were still current in the cache
+    size_t anchorFiles = 0;         // targets whose headings were needed
+    size_t anchorsParsed = 0;       // read and parsed; the rest came from the index or the cache
+};
+
+// Resolves the relative links and #anchors of Markdown files against the
+// file system and the headings of the files they point at. External links
+// are not followed.
+//
+// Each target directory is listed once per check instead of each target
+// being stat'ed, and the listing is kept until the directory's own time
+// changes. The headings of a target come from the workspace index when its
+// entry is current, or else from a parse that is kept until the file's time
+// or size changes. Links are resolved, directories listed and files parsed
+// on the pool.
+class LinkChecker
+{
+public:
+    // Every link of every file in index.
+    std::vector<BrokenLink> checkWorkspace(const WorkspaceIndex& index, ThreadPool& pool, const CancelToken& cancel);
+
+    // The links of one document, from its summary rather than the file, so
+    // unsaved edits count. root resolves links that start with /; index,
+    // when there is one, supplies the headings of other files.
+    std::vector<BrokenLink> checkDocument(const std::filesystem::path& path, const MarkdownSummary& summary,
+                                          const std::filesystem::path& root, const WorkspaceIndex* index,
+                                          ThreadPool& pool, const CancelToken& cancel);
+
+    const LinkCheckStats& lastStats() const { return stats_; }
+
+private:
+    struct Link
+    {
+        int line;
+        int column;
+        LinkKind kind;
+        std::string_view target;
+    };
+
+    // The links of a document and what resolving them needs from it.
+    struct Document
+    {
+        std::filesystem::path path;
+        std::vector<Link> links;                    // including reference definitions
+        std::vector<std::string> labels;            // defined reference labels, normalized and sorted
+        std::shared_ptr<const std::vector<std::string>> anchors;   // sorted
+    };
+
+    struct Listing
+    {
+        int64_t modified = 0;
+        bool exists = false;
+        std::unordered_set<std::string> names;
+    };
+
+    struct Anchors
+    {
+        int64_t modified = 0;
+        uint64_t size = 0;
+        std::shared_ptr<const std::vector<std::string>> anchors;
+    };
+
+    std::vector<BrokenLink> check(std::vector<Document>& documents, const std::filesystem::path& root,
+                                  const WorkspaceIndex* index, ThreadPool& pool, const CancelToken& cancel);
+
+    std::mutex mutex_;                                      // one check at a time
+    std::unordered_map<std::string, Listing> listings_;     // by directory
+    std::unordered_map<std::string, Anchors> anchors_;      // by file
+    LinkCheckStats stats_;
+};
+
+// A reference label the way labels are matched: blanks at either end
+// dropped, runs of blanks inside made one space, ASCII letters lower case.
+std::string normalizeLabel(std::string_view label);
+
+// How a problem reads in a list of broken links.
+const char* linkProblemName(LinkProblem problem);
@@ -0,0 +1,248 @@
+#include "LinkCompletion.h"
+
+#include <algorithm>
+
+namespace {
+
+inline char lowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string lowerCase(std::string_view text)
+{
+    std::string lower(text);
+    for (char& c : lower) c = lowerAscii(c);
+    return lower;
+}
+
+// Whether needle, already lower case, starts text, ignoring ASCII case.
+bool startsWithLower(std::string_view text, std::string_view needle)
+{
+    if (text.size() < needle.size()) return false;
+    for (size_t i = 0; i < needle.size(); i++) {
+        if (lowerAscii(text[i]) != needle[i]) return false;
+    }
+    return true;
+}
+
+bool containsLower(std::string_view text, std::string_view needle)
+{
+    for (size_t i = 0; i + needle.size() <= text.size(); i++) {
+        if (startsWithLower(text.substr(i), needle)) return true;
+    }
+    return false;
+}
+
+// Whether the characters of needle appear in text in order.
+bool holdsLower(std::string_view text, std::string_view needle)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < text.size() && n < needle.size(); i++) {
+        if (lowerAscii(text[i]) == needle[n]) n++;
+    }
+    return n == needle.size();
+}
+
+// The directory of a target, the part up to its last /, folded onto the
+// directory of the document: "" for the root, otherwise ending in /. False
+// when it climbs above the root.
+bool resolveDirectory(std::string_view directory, std::string_view relative, std::string& resolved)
+{
+    resolved.clear();
+    if (relative.empty() || relative[0] != '/') {
+        resolved.assign(directory);
+        if (!resolved.empty()) resolved += '/';
+    }
+    size_t from = 0;
+    while (from < relative.size()) {
+        size_t end = relative.find('/', from);
+        if (end == std::string_view::npos) end = relative.size();
+        const std::string_view segment = relative.substr(from, end - from);
+        from = end + 1;
+        if (segment.empty() || segment == ".") continue;
+        if (segment == "..") {
+            if (resolved.empty()) return false;
+            resolved.pop_back();
+            const size_t slash = resolved.rfind('/');
+            resolved.resize((slash == std::string::npos) ? 0 : slash + 1);
+            continue;
+        }
+        resolved += segment;
+        resolved += '/';
+    }
+    return true;
+}
+
+// path, relative to the root, as a link written in directory reaches it.
+std::string relativeTo(std::string_view directory, std::string_view path)
+{
+    // The leading directories the two share, with their slashes.
+    size_t shared = 0;
+    while (shared < directory.size()) {
+        size_t end = directory.find('/', shared);
+        if (end == std::string_view::npos) end = directory.size();
+        if (path.size() <= end || path.compare(shared, end - shared, directory.substr(shared, end - shared)) != 0 ||
+            path[end] != '/') {
+            break;
+        }
+        shared = end + 1;
+    }
+
+    std::string relative;
+    if (shared < directory.size()) {
+        relative += "../";
+        for (size_t i = shared; i < directory.size(); i++) {
+            if (directory[i] == '/') relative += "../";
+        }
+    }
+    relative += path.substr(std::min(shared, path.size()));
+    return relative;
+}
+
+}
+
+LinkCompletionContext findLinkCompletion(std::string_view before)
+{
+    LinkCompletionContext context;
+    const size_t inlineStart = before.rfind("](");
+    const size_t labelStart = before.rfind("][");
+    if (inlineStart == std::string_view::npos && labelStart == std::string_view::npos) return context;
+
+    if (labelStart != std::string_view::npos && (inlineStart == std::string_view::npos || labelStart > inlineStart)) {
+        const std::string_view label = before.substr(labelStart + 2);
+        if (label.find_first_of("[]") != std::string_view::npos) return context;
+        context.kind = COMPLETE_LABEL;
+        context.typed = label;
+        return context;
+    }
+
+    // A blank, a bracket or a second # ends the destination.
+    const std::string_view target = before.substr(inlineStart + 2);
+    if (target.find_first_of(" \t()<>[]") != std::string_view::npos) return context;
+    const size_t hash = target.find('#');
+    if (hash == std::string_view::npos) {
+        context.kind = COMPLETE_PATH;
+        context.typed = target;
+    } else if (target.find('#', hash + 1) == std::string_view::npos) {
+        context.kind = COMPLETE_ANCHOR;
+        context.path = target.substr(0, hash);
+        context.typed = target.substr(hash + 1);
+    }
+    return context;
+}
+
+std::vector<std::string> matchCompletions(const std::vector<std::string>& items, std::string_view typed,
+                                          size_t limit)
+{
+    const std::string needle = lowerCase(typed);
+    std::vector<std::string> starting;
+    std::vector<std::string> holding;
+    std::vector<std::string> scattered;
+    for (const std::string& item : items) {
+        if (starting.size() >= limit) break;
+        if (startsWithLower(item, needle)) {
+            starting.push_back(item);
+        } else if (holding.size() < limit && containsLower(item, needle)) {
+            holding.push_back(item);
+        } else if (scattered.size() < limit && holdsLower(item, needle)) {
+            scattered.push_back(item);
+        }
+    }
+    for (std::vector<std::string>* group : { &holding, &scattered }) {
+        for (std::string& item : *group) {
+            if (starting.size() >= limit) break;
+            starting.push_back(std::move(item));
+        }
+    }
+    return starting;
+}
+
+PathCompletion::PathCompletion(std::shared_ptr<const WorkspaceIndex> index) : index_(std::move(index))
+{
+    const size_t count = index_->fileCount();
+    keys_.reserve(count);
+    sorted_.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        keys_.push_back(lowerCase(index_->path(i)));
+        sorted_[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(sorted_.begin(), sorted_.end(), [this](uint32_t a, uint32_t b) { return keys_[a] < keys_[b]; });
+}
+
+std::vector<std::string> PathCompletion::complete(std::string_view directory, std::string_view typed,
+                                                  size_t limit) const
+{
+    const size_t slash = typed.rfind('/');
+    const std::string_view typedDirectory = typed.substr(0, (slash == std::string_view::npos) ? 0 : slash + 1);
+    const std::string stem = lowerCase(typed.substr(typedDirectory.size()));
+
+    // Files under the directory typed, in order.
+    std::vector<std::string> completions;
+    std::string resolved;
+    std::string prefix;
+    const bool inRoot = resolveDirectory(directory, typedDirectory, resolved);
+    if (inRoot) {
+        prefix = lowerCase(resolved) + stem;
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), prefix,
+                                   [this](uint32_t file, const std::string& key) { return keys_[file] < key; });
+        for (; it != sorted_.end() && completions.size() < limit; ++it) {
+            const std::string& key = keys_[*it];
+            if (key.compare(0, prefix.size(), prefix) != 0) break;
+            completions.push_back(std::string(typedDirectory) + std::string(index_->path(*it).substr(resolved.size())));
+        }
+    }
+    if (stem.empty() || completions.size() >= limit) return completions;
+
+    // Then any file holding what follows the last /, wherever it is.
+    const size_t wanted = limit - completions.size();
+    std::vector<uint32_t> holding;
+    std::vector<uint32_t> scattered;
+    for (uint32_t file : sorted_) {
+        const std::string& key = keys_[file];
+        if (inRoot && key.compare(0, prefix.size(), prefix) == 0) continue;
+        if (key.find(stem) != std::string::npos) {
+            holding.push_back(file);
+            if (holding.size() >= wanted) break;
+        } else if (scattered.size() < wanted && holdsLower(key, stem)) {
+            scattered.push_back(file);
+        }
+    }
+    for (const std::vector<uint32_t>* group : { &holding, &scattered }) {
+        for (uint32_t file : *group) {
+            if (completions.size() >= limit) break;
+            completions.push_back(relativeTo(directory, index_->path(file)));
+        }
+    }
+    return completions;
+}
+
+int PathCompletion::findFile(std::string_view directory, std::string_view target) const
+{
+    std::string resolved;
+    if (!resolveDirectory(directory, std::string(target) + "/", resolved) || resolved.empty()) return -1;
+    resolved.pop_back();
+    return index_->findFile(resolved);
+}
+
+std::vector<std::string> PathCompletion::anchors(int file) const
+{
+    std::vector<std::string> anchors;
+    if (file < 0) return anchors;
+    for (const IndexHeading& heading : index_->headings(file)) {
+        const std::string_view anchor = index_->string(heading.anchor);
+        if (!anchor.empty()) anchors.emplace_back(anchor);
+    }
+    return anchors;
+}
+
+std::vector<std::string> PathCompletion::labels(int file) const
+{
+    std::vector<std::string> labels;
+    if (file < 0) return labels;
+    for (const IndexReference& reference : index_->references(file)) {
+        const std::string_view label = index_->string(reference.label);
+        if (std::find(labels.begin(), labels.end(), label) == labels.end()) labels.emplace_back(label);
+    }
+    return labels;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "WorkspaceIndex.h"
+
+enum LinkCompletionKind
+{
+    COMPLETE_NONE,
+    COMPLETE_PATH,          // ](target
+    COMPLETE_ANCHOR,        // ](target#anchor, or ](#anchor in the same document
+    COMPLETE_LABEL          // ][label
+};
+
+// What is being typed at the caret.
+struct LinkCompletionContext
+{
+    LinkCompletionKind kind = COMPLETE_NONE;
+    std::string_view path;      // COMPLETE_ANCHOR: the file, empty for the same document
+    std::string_view typed;     // what a completion replaces
+};
+
+// The context of the caret from the text of its line before it: inside the
+// destination of an inline link, or the label of a reference link.
+LinkCompletionContext findLinkCompletion(std::string_view lineBeforeCaret);
+
+// Up to limit of items matching typed, ignoring ASCII case: the ones
+// starting with it, then the ones holding it, then the ones holding its
+// characters in order. Each group keeps the order of items.
+std::vector<std::string> matchCompletions(const std::vector<std::string>& items, std::string_view typed,
+                                          size_t limit);
+
+// The files of a workspace index, ready for completing link targets. The
+// lower-case paths are sorted once, so what follows the typed directory is
+// a binary search; the looser matches are one pass over the keys. Build it
+// off the UI thread whenever the index changes.
+class PathCompletion
+{
+public:
+    explicit PathCompletion(std::shared_ptr<const WorkspaceIndex> index);
+
+    const WorkspaceIndex& index() const { return *index_; }
+
+    // Up to limit link targets for typed, written in a document in directory.
+    // directory is relative to the root, / separated, and empty for the root.
+    // Files under the directory typed come first, as typed; the rest are
+    // made relative to directory.
+    std::vector<std::string> complete(std::string_view directory, std::string_view typed, size_t limit) const;
+
+    // The file a target written in directory points at, or -1.
+    int findFile(std::string_view directory, std::string_view target) const;
+
+    // The heading anchors of a file, with GitHub's suffixes for repeats.
+    std::vector<std::string> anchors(int file) const;
+
+    // The reference labels a file defines, as written.
+    std::vector<std::string> labels(int file) const;
+
+private:
+    std::shared_ptr<const WorkspaceIndex> index_;
+    std::vector<std::string> keys_;     // lower-case paths, by file
+    std::vector<uint32_t> sorted_;      // files in key order
+};
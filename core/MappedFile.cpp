@@ -0,0 +1,91 @@
+#include "MappedFile.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+    close();
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size) || static_cast<unsigned long long>(size.QuadPart) > SIZE_MAX) {
+        ::CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart > 0) {
+        HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            data_ = static_cast<const char*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            ::CloseHandle(mapping);
+        }
+        if (!data_) {
+            ::CloseHandle(file);
+            return false;
+        }
+    }
+    ::CloseHandle(file);
+    size_ = static_cast<size_t>(size.QuadPart);
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) ::UnmapViewOfFile(data_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+    close();
+    const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (::fstat(file, &info) != 0) {
+        ::close(file);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+        if (view == MAP_FAILED) {
+            ::close(file);
+            return false;
+        }
+        data_ = static_cast<const char*>(view);
+    }
+    ::close(file);
+    size_ = static_cast<size_t>(info.st_size);
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_) ::munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
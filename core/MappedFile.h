@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+// A file mapped read-only into memory. The file handle is closed as soon as
+// the view exists; on Windows the file can still be renamed, though not
+// replaced, while it is mapped.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map path, dropping whatever was mapped before. An empty file opens
+    // with an empty view.
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const { return open_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../plugin/Scintilla.h"
+#include "MarkdownLexer.h"
+
+// The Scintilla fold level of a line at depth, followed by a line at
+// nextDepth. A line is a fold header when the line after it is deeper.
+inline int markdownFoldLevel(int depth, int nextDepth)
+{
+    return (SC_FOLDLEVELBASE + depth) | ((nextDepth > depth) ? SC_FOLDLEVELHEADERFLAG : 0);
+}
+
+// Set the fold levels of lines [first, last) of a lex whose first line is
+// document line origin, skipping lines whose level is already right. The
+// line before them is checked too: whether it is a header depends on the
+// first of them. lineCount counts the lines holding text, which leaves out
+// the empty line after a line end at the end of the document, as lexing
+// does. get(line) and set(line, level) read and write a document line's
+// level.
+template <typename Get, typename Set>
+void updateFoldLevels(const LexOutput& lexed, size_t first, size_t last, Sci_Position origin,
+                      Sci_Position lineCount, Get get, Set set)
+{
+    auto depthOf = [&](Sci_Position line) {
+        const Sci_Position k = line - origin;
+        if (k >= static_cast<Sci_Position>(first) && k < static_cast<Sci_Position>(last)) return static_cast<int>(lexed.foldDepths[k]);
+        return (get(line) & SC_FOLDLEVELNUMBERMASK) - SC_FOLDLEVELBASE;
+    };
+
+    const Sci_Position from = (origin + static_cast<Sci_Position>(first) > 0) ? origin + first - 1 : 0;
+    const Sci_Position to = origin + static_cast<Sci_Position>(last);
+    int depth = depthOf(from);
+    for (Sci_Position line = from; line < to; line++) {
+        const int nextDepth = (line + 1 < lineCount) ? depthOf(line + 1) : depth;
+        const int level = markdownFoldLevel(depth, nextDepth);
+        if (get(line) != level) set(line, level);
+        depth = nextDepth;
+    }
+}
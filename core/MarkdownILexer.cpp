@@ -0,0 +1,330 @@
+#include "MarkdownILexer.h"
+#include "DocumentView.h"
+#include "MarkdownFolding.h"
+#include "MarkdownStyles.h"
+#include "ParallelLexer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#ifndef SCLEX_AUTOMATIC
+#define SCLEX_AUTOMATIC 1000
+#endif
+
+namespace {
+
+const char* const styleNames[] = {
+    "DEFAULT", "LINE_BEGIN", "STRONG1", "STRONG2", "EM1", "EM2",
+    "HEADER1", "HEADER2", "HEADER3", "HEADER4", "HEADER5", "HEADER6",
+    "PRECHAR", "ULIST_ITEM", "OLIST_ITEM", "BLOCKQUOTE", "STRIKEOUT", "HRULE",
+    "LINK", "CODE", "CODE2", "CODEBK",
+    "CODE_KEYWORD", "CODE_STRING", "CODE_COMMENT", "CODE_NUMBER", "CODE_PREPROC", "CODE_KEY",
+    "TABLE_PIPE", "TABLE_HEADER", "TABLE_ALIGN",
+};
+
+const int styleCount = sizeof(styleNames) / sizeof(styleNames[0]);
+
+// Lines lexed at a time, so a pass that rejoins the previous one early does
+// not pay for the rest of the requested range.
+const Sci_Position sliceLines = 256;
+
+}
+
+Scintilla::ILexer5* SCI_METHOD MarkdownILexer::create()
+{
+    return new MarkdownILexer();
+}
+
+int SCI_METHOD MarkdownILexer::Version() const
+{
+    return Scintilla::lvRelease5;
+}
+
+void SCI_METHOD MarkdownILexer::Release()
+{
+    delete this;
+}
+
+const char* SCI_METHOD MarkdownILexer::PropertyNames()
+{
+    return "";
+}
+
+int SCI_METHOD MarkdownILexer::PropertyType(const char*)
+{
+    return 0;
+}
+
+const char* SCI_METHOD MarkdownILexer::DescribeProperty(const char*)
+{
+    return "";
+}
+
+Sci_Position SCI_METHOD MarkdownILexer::PropertySet(const char*, const char*)
+{
+    return -1;
+}
+
+const char* SCI_METHOD MarkdownILexer::DescribeWordListSets()
+{
+    return "";
+}
+
+Sci_Position SCI_METHOD MarkdownILexer::WordListSet(int, const char*)
+{
+    return -1;
+}
+
+void SCI_METHOD MarkdownILexer::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int, Scintilla::IDocument* pAccess)
+{
+    const Sci_Position docLength = pAccess->Length();
+    Sci_Position endPos = static_cast<Sci_Position>(startPos) + lengthDoc;
+    if (endPos > docLength) endPos = docLength;
+
+    // Lines can only be rejoined when every edit since the last pass was
+    // reported. A length other than the one the reported edits add up to
+    // means one was missed, and only the lines Scintilla asks for are known.
+    if (docLength != length_) forgetStyled();
+    length_ = docLength;
+
+    // Start one line early so a setext underline typed below a paragraph
+    // restyles the paragraph line, and finish at the end of the line after
+    // endPos so the last line requested can see its underline too.
+    const Sci_Position startLine = pAccess->LineFromPosition(static_cast<Sci_Position>(startPos));
+    const Sci_Position firstLine = (startLine > 0) ? startLine - 1 : 0;
+    const Sci_Position lastLine = pAccess->LineFromPosition(endPos);
+
+    // The previous pass can be rejoined on any line after the edits, as long
+    // as it covered this range and every edit lies inside it. The state kept
+    // for an edited line belongs to its old text, so only lines past the
+    // last edited one are compared.
+    bool resumable = firstLine <= styledEnd_ && (dirtyStart_ < 0 || dirtyStart_ >= firstLine);
+    const Sci_Position cleanFrom = std::max(startLine, dirtyEnd_ + 1);
+
+    LexerDocumentView document(pAccess, text_);
+    Sci_Position lineCount = pAccess->LineFromPosition(docLength) + 1;
+    if (lineCount > 1 && pAccess->LineStart(lineCount - 1) == docLength) lineCount--;
+    auto getLevel = [pAccess](Sci_Position line) { return pAccess->GetLevel(line); };
+    auto setLevel = [pAccess](Sci_Position line, int level) { pAccess->SetLevel(line, level); };
+    int state = (firstLine > 0) ? pAccess->GetLineState(firstLine - 1) : 0;
+    Sci_Position line = firstLine;
+    Sci_Position reached = firstLine;
+    bool rejoined = false;
+
+    // With nothing to rejoin, as on the first pass over a file, a large range
+    // is lexed in one go on the shared pool rather than slice by slice.
+    const bool canRejoin = resumable && cleanFrom + 1 < styledEnd_;
+    const Sci_Position rangeStart = pAccess->LineStart(firstLine);
+    const Sci_Position rangeEnd = std::min(docLength, pAccess->LineStart(lastLine + 1));
+    if (!canRejoin && rangeEnd - rangeStart >= static_cast<Sci_Position>(parallelLexThreshold)) {
+        const std::string_view text = document.range(rangeStart, rangeEnd - rangeStart);
+        lexMarkdownParallel(text, state, firstLine == 0, out_, ThreadPool::shared());
+        const Sci_Position count = static_cast<Sci_Position>(out_.lineStates.size());
+        pAccess->StartStyling(rangeStart);
+        pAccess->SetStyles(static_cast<Sci_Position>(text.size()), out_.styles.data());
+        for (Sci_Position k = 0; k < count; k++) {
+            if (pAccess->GetLineState(firstLine + k) != out_.lineStates[k]) pAccess->SetLineState(firstLine + k, out_.lineStates[k]);
+        }
+        updateFoldLevels(out_, 0, static_cast<size_t>(count), firstLine, lineCount, getLevel, setLevel);
+        reached = firstLine + count;
+        line = lastLine + 1;
+    }
+
+    while (line <= lastLine) {
+        // Each slice lexes one line past the lines it keeps, for the setext
+        // lookahead.
+        const Sci_Position sliceEnd = std::min(lastLine, line + sliceLines - 1);
+        const Sci_Position lexStart = pAccess->LineStart(line);
+        Sci_Position lexEnd = pAccess->LineStart(std::min(lastLine, sliceEnd + 1) + 1);
+        if (lexEnd > docLength) lexEnd = docLength;
+        if (lexEnd <= lexStart) break;
+
+        const std::string_view text = document.range(lexStart, lexEnd - lexStart);
+        lexMarkdown(text, state, line == 0, out_);
+
+        // Stop at the first line past the edits that ends in the state the
+        // previous pass left there: nothing after it can have changed. The
+        // last line requested was lexed without its lookahead, so it cannot
+        // be the one.
+        const Sci_Position count = std::min(static_cast<Sci_Position>(out_.lineStates.size()), sliceEnd - line + 1);
+        const Sci_Position lastComplete = (lexEnd == docLength) ? lastLine : lastLine - 1;
+        Sci_Position used = count;
+        bool converged = false;
+        for (Sci_Position k = 0; resumable && k < count; k++) {
+            const Sci_Position j = line + k;
+            if (j >= cleanFrom && j <= lastComplete && j + 1 < styledEnd_ &&
+                out_.lineStates[k] == pAccess->GetLineState(j)) {
+                used = k + 1;
+                converged = true;
+                break;
+            }
+        }
+        if (used == 0) break;
+
+        const size_t usedLength = (static_cast<size_t>(used) < out_.lines.count()) ? out_.lines.starts[used] : text.size();
+        pAccess->StartStyling(lexStart);
+        pAccess->SetStyles(static_cast<Sci_Position>(usedLength), out_.styles.data());
+        for (Sci_Position k = 0; k < used; k++) {
+            if (pAccess->GetLineState(line + k) != out_.lineStates[k]) pAccess->SetLineState(line + k, out_.lineStates[k]);
+        }
+        updateFoldLevels(out_, 0, static_cast<size_t>(used), line, lineCount, getLevel, setLevel);
+        reached = line + used;
+
+        if (converged) {
+            // Lines up to styledEnd_ keep their styles, except the last one:
+            // the line after it may have been edited, and it is the setext
+            // lookahead. Carry on from there if the request reaches it.
+            resumable = false;
+            rejoined = true;
+            line = styledEnd_ - 1;
+            reached = line;
+            pAccess->StartStyling(std::min(pAccess->LineStart(line), docLength));
+            state = pAccess->GetLineState(line - 1);
+            continue;
+        }
+
+        state = out_.lineStates[used - 1];
+        line += used;
+    }
+
+    if (reached == firstLine || firstLine > styledEnd_) return;
+    if (!rejoined && reached < styledEnd_) {
+        // The lines below were styled from a state this pass has replaced,
+        // so they can only be rejoined past its last line.
+        if (dirtyStart_ < 0 || reached > dirtyEnd_) dirtyEnd_ = reached - 1;
+        dirtyStart_ = reached - 1;
+    } else {
+        styledEnd_ = std::max(styledEnd_, reached);
+        dirtyStart_ = -1;
+        dirtyEnd_ = -1;
+    }
+}
+
+// Fold levels are set by Lex(), from the same pass that styles the lines.
+void SCI_METHOD MarkdownILexer::Fold(Sci_PositionU, Sci_Position, int, Scintilla::IDocument*)
+{
+}
+
+void* SCI_METHOD MarkdownILexer::PrivateCall(int operation, void* pointer)
+{
+    if (operation == BETTERMD_CALL_EDIT && pointer) noteEdit(*static_cast<const LexerEdit*>(pointer));
+    if (operation == BETTERMD_CALL_STYLED && pointer) noteStyled(*static_cast<const LexerStyled*>(pointer));
+    return nullptr;
+}
+
+int SCI_METHOD MarkdownILexer::LineEndTypesSupported()
+{
+    return 0;
+}
+
+int SCI_METHOD MarkdownILexer::AllocateSubStyles(int, int)
+{
+    return -1;
+}
+
+int SCI_METHOD MarkdownILexer::SubStylesStart(int)
+{
+    return -1;
+}
+
+int SCI_METHOD MarkdownILexer::SubStylesLength(int)
+{
+    return 0;
+}
+
+int SCI_METHOD MarkdownILexer::StyleFromSubStyle(int subStyle)
+{
+    return subStyle;
+}
+
+int SCI_METHOD MarkdownILexer::PrimaryStyleFromStyle(int style)
+{
+    return style;
+}
+
+void SCI_METHOD MarkdownILexer::FreeSubStyles()
+{
+}
+
+void SCI_METHOD MarkdownILexer::SetIdentifiers(int, const char*)
+{
+}
+
+int SCI_METHOD MarkdownILexer::DistanceToSecondaryStyles()
+{
+    return 0;
+}
+
+const char* SCI_METHOD MarkdownILexer::GetSubStyleBases()
+{
+    return "";
+}
+
+int SCI_METHOD MarkdownILexer::NamedStyles()
+{
+    return styleCount;
+}
+
+const char* SCI_METHOD MarkdownILexer::NameOfStyle(int style)
+{
+    return (style >= 0 && style < styleCount) ? styleNames[style] : "";
+}
+
+const char* SCI_METHOD MarkdownILexer::TagsOfStyle(int)
+{
+    return "";
+}
+
+const char* SCI_METHOD MarkdownILexer::DescriptionOfStyle(int)
+{
+    return "";
+}
+
+const char* SCI_METHOD MarkdownILexer::GetName()
+{
+    return BETTERMD_LEXER_NAME;
+}
+
+int SCI_METHOD MarkdownILexer::GetIdentifier()
+{
+    return SCLEX_AUTOMATIC;
+}
+
+const char* SCI_METHOD MarkdownILexer::PropertyGet(const char*)
+{
+    return "";
+}
+
+// Shift the tracked lines by an edit and widen the dirty range over it.
+void MarkdownILexer::noteEdit(const LexerEdit& edit)
+{
+    if (length_ >= 0) length_ += edit.lengthAdded;
+    if (edit.line >= styledEnd_) return;
+
+    const Sci_Position lastEdited = edit.line + std::max<Sci_Position>(edit.linesAdded, 0);
+    styledEnd_ = std::max(edit.line + 1, styledEnd_ + edit.linesAdded);
+
+    if (dirtyStart_ < 0) {
+        dirtyStart_ = edit.line;
+        dirtyEnd_ = lastEdited;
+        return;
+    }
+    if (dirtyEnd_ > edit.line) dirtyEnd_ = std::max(edit.line, dirtyEnd_ + edit.linesAdded);
+    dirtyStart_ = std::min(dirtyStart_, edit.line);
+    dirtyEnd_ = std::max(dirtyEnd_, lastEdited);
+}
+
+void MarkdownILexer::forgetStyled()
+{
+    styledEnd_ = 0;
+    dirtyStart_ = -1;
+    dirtyEnd_ = -1;
+}
+
+// Lines styled by the plugin continue this lexer's pass when they start
+// inside it. The last line it styled is left out: it was styled without the
+// line after it.
+void MarkdownILexer::noteStyled(const LexerStyled& styled)
+{
+    if (styled.firstLine <= styledEnd_ && styled.endLine > styledEnd_) styledEnd_ = styled.endLine - 1;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+
+#include "../plugin/ILexer.h"
+#include "MarkdownLexer.h"
+
+#define BETTERMD_LEXER_NAME "BetterMarkdown"
+
+// SCI_PRIVATELEXERCALL operation reporting an edit to the lexer; the pointer
+// is a LexerEdit. The plugin forwards SCN_MODIFIED so the lexer knows which
+// lines changed since its last pass.
+#define BETTERMD_CALL_EDIT 0x424D4401
+
+struct LexerEdit
+{
+    Sci_Position line;          // first line the edit touched
+    Sci_Position linesAdded;    // negative when lines were removed
+    Sci_Position lengthAdded;   // bytes; negative when text was removed
+};
+
+// SCI_PRIVATELEXERCALL operation reporting lines the plugin styled itself,
+// from a lex run on a worker thread; the pointer is a LexerStyled.
+#define BETTERMD_CALL_STYLED 0x424D4402
+
+struct LexerStyled
+{
+    Sci_Position firstLine;
+    Sci_Position endLine;       // one past the last line styled
+};
+
+// Scintilla lexer object wrapping lexMarkdown(). Scintilla owns each
+// instance once it is installed with SCI_SETILEXER and frees it via Release().
+class MarkdownILexer : public Scintilla::ILexer5
+{
+public:
+    static Scintilla::ILexer5* SCI_METHOD create();
+
+    int SCI_METHOD Version() const override;
+    void SCI_METHOD Release() override;
+    const char* SCI_METHOD PropertyNames() override;
+    int SCI_METHOD PropertyType(const char* name) override;
+    const char* SCI_METHOD DescribeProperty(const char* name) override;
+    Sci_Position SCI_METHOD PropertySet(const char* key, const char* val) override;
+    const char* SCI_METHOD DescribeWordListSets() override;
+    Sci_Position SCI_METHOD WordListSet(int n, const char* wl) override;
+    void SCI_METHOD Lex(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument* pAccess) override;
+    void SCI_METHOD Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument* pAccess) override;
+    void* SCI_METHOD PrivateCall(int operation, void* pointer) override;
+    int SCI_METHOD LineEndTypesSupported() override;
+    int SCI_METHOD AllocateSubStyles(int styleBase, int numberStyles) override;
+    int SCI_METHOD SubStylesStart(int styleBase) override;
+    int SCI_METHOD SubStylesLength(int styleBase) override;
+    int SCI_METHOD StyleFromSubStyle(int subStyle) override;
+    int SCI_METHOD PrimaryStyleFromStyle(int style) override;
+    void SCI_METHOD FreeSubStyles() override;
+    void SCI_METHOD SetIdentifiers(int style, const char* identifiers) override;
+    int SCI_METHOD DistanceToSecondaryStyles() override;
+    const char* SCI_METHOD GetSubStyleBases() override;
+    int SCI_METHOD NamedStyles() override;
+    const char* SCI_METHOD NameOfStyle(int style) override;
+    const char* SCI_METHOD TagsOfStyle(int style) override;
+    const char* SCI_METHOD DescriptionOfStyle(int style) override;
+    const char* SCI_METHOD GetName() override;
+    int SCI_METHOD GetIdentifier() override;
+    const char* SCI_METHOD PropertyGet(const char* key) override;
+
+private:
+    MarkdownILexer() = default;
+    virtual ~MarkdownILexer() = default;
+
+    void noteEdit(const LexerEdit& edit);
+    void noteStyled(const LexerStyled& styled);
+    void forgetStyled();
+
+    // Reused between calls so typing does not allocate. text_ holds the
+    // slice being lexed when it is copied out of the document.
+    std::string text_;
+    LexOutput out_;
+
+    // Lines [0, styledEnd_) hold styles and states from an earlier pass.
+    // Edited lines inside that range are kept in [dirtyStart_, dirtyEnd_]
+    // until they are lexed again; dirtyStart_ is -1 when there are none.
+    Sci_Position styledEnd_ = 0;
+    Sci_Position dirtyStart_ = -1;
+    Sci_Position dirtyEnd_ = -1;
+
+    // The document length at the end of the last pass, moved by each edit
+    // reported since. An edit that was not reported, such as one made with
+    // modification events off, leaves it wrong, and the next pass drops the
+    // lines tracked above instead of rejoining them.
+    Sci_Position length_ = -1;
+};
@@ -0,0 +1,1067 @@
+#include "MarkdownLexer.h"
+#include "CodeLexer.h"
+#include "MarkdownStyles.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct Line
+{
+    const char* begin;   // first character of the line
+    const char* end;     // end of the content, before the line ending
+    const char* next;    // start of the following line
+};
+
+// What a line adds to its fold depth beyond the states around it.
+struct LineFold
+{
+    int heading = 0;        // level of a top-level heading on the line
+    bool item = false;      // the line holds a list marker
+};
+
+struct LineClass
+{
+    LineKind kind;
+    const char* content;   // first non-blank character
+    int indent;            // columns of leading whitespace
+    int marker;            // heading level, fence length or list marker width
+};
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isAlpha(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool isAlnum(char c)
+{
+    return isDigit(c) || isAlpha(c);
+}
+
+Line lineAt(std::string_view text, const LineTable& lines, size_t i)
+{
+    Line line;
+    line.begin = text.data() + lines.starts[i];
+    line.next = (i + 1 < lines.count()) ? text.data() + lines.starts[i + 1] : text.data() + text.size();
+    line.end = line.next;
+    while (line.end > line.begin && (line.end[-1] == '\n' || line.end[-1] == '\r')) line.end--;
+    return line;
+}
+
+int runLength(const char* p, const char* end, char c)
+{
+    const char* q = p;
+    while (q < end && *q == c) q++;
+    return static_cast<int>(q - p);
+}
+
+bool onlyBlanks(const char* p, const char* end)
+{
+    for (; p < end; p++) {
+        if (!isBlank(*p)) return false;
+    }
+    return true;
+}
+
+// Expand the class of the line content [begin, end) with the details the
+// lexer needs.
+LineClass expandClass(const char* begin, const char* end, unsigned char cls)
+{
+    LineClass lc = { lineKind(cls), begin, 0, 0 };
+
+    const char* p = begin;
+    int indent = 0;
+    while (p < end && isBlank(*p)) {
+        indent = (*p == '\t') ? (indent + 4) & ~3 : indent + 1;
+        p++;
+    }
+    lc.content = p;
+    lc.indent = indent;
+
+    switch (lc.kind) {
+    case LK_ATX:
+        lc.marker = lineArg(cls);
+        break;
+    case LK_FENCE:
+        lc.marker = runLength(p, end, *p);
+        break;
+    case LK_ULIST:
+        lc.marker = 1;
+        break;
+    case LK_OLIST: {
+        const char* q = p;
+        while (isDigit(*q)) q++;
+        lc.marker = static_cast<int>(q + 1 - p);
+        break;
+    }
+    default:
+        break;
+    }
+    return lc;
+}
+
+// A run of '=' or '-' with optional indent and trailing blanks turns the
+// paragraph line above it into a level 1 or 2 heading.
+int setextLevel(const char* p, const char* end)
+{
+    int indent = 0;
+    while (p < end && *p == ' ' && indent < 4) {
+        p++;
+        indent++;
+    }
+    if (p == end || (*p != '=' && *p != '-')) return 0;
+    const int n = runLength(p, end, *p);
+    if (!onlyBlanks(p + n, end)) return 0;
+    return (*p == '=') ? 1 : 2;
+}
+
+}
+
+void LinkMatcher::reset(const char* begin, const char* end)
+{
+    begin_ = begin;
+    end_ = end;
+    paired_ = false;
+}
+
+void LinkMatcher::pair()
+{
+    partner_.assign(end_ - begin_, unpaired);
+    brackets_.clear();
+    parens_.clear();
+    for (const char* p = begin_; p < end_; p++) {
+        const uint32_t at = static_cast<uint32_t>(p - begin_);
+        switch (*p) {
+        case '\\':
+            p++;
+            break;
+        case '[':
+            brackets_.push_back(at);
+            break;
+        case '(':
+            parens_.push_back(at);
+            break;
+        case ']':
+            if (!brackets_.empty()) {
+                partner_[brackets_.back()] = at;
+                brackets_.pop_back();
+            }
+            break;
+        case ')':
+            if (!parens_.empty()) {
+                partner_[parens_.back()] = at;
+                parens_.pop_back();
+            }
+            break;
+        }
+    }
+    paired_ = true;
+}
+
+const char* LinkMatcher::match(const char* p, const char* end)
+{
+    if (!paired_) pair();
+    const uint32_t textEnd = partner_[p - begin_];
+    if (textEnd == unpaired) return nullptr;
+    const char* q = begin_ + textEnd + 1;
+    if (q >= end || (*q != '(' && *q != '[')) return nullptr;
+    const uint32_t close = partner_[q - begin_];
+    if (close == unpaired || begin_ + close >= end) return nullptr;
+    return begin_ + close + 1;
+}
+
+const char* matchAutolink(const char* p, const char* end)
+{
+    const char* q = p + 1;
+    while (q < end && (isAlnum(*q) || *q == '+' || *q == '.' || *q == '-')) q++;
+    if (q - p < 3 || q >= end || *q != ':') return nullptr;
+    for (; q < end; q++) {
+        if (*q == '>') return q + 1;
+        if (*q == '<' || isBlank(*q)) return nullptr;
+    }
+    return nullptr;
+}
+
+namespace {
+
+void fill(char* styles, const char* base, const char* from, const char* to, char style)
+{
+    if (to > from) memset(styles + (from - base), style, to - from);
+}
+
+// A run of '*', '_' or '~' that may open or close emphasis. Runs are kept
+// in text order; prev and next link the runs still in play.
+struct Delimiter
+{
+    const char* pos;    // first character of the run not yet matched
+    int length;         // characters of the run not yet matched
+    int origLength;     // length of the whole run
+    char c;
+    bool canOpen;
+    bool canClose;
+    int prev;
+    int next;
+};
+
+// A styled range found while scanning a span of inline text.
+struct InlineSpan
+{
+    const char* from;
+    const char* to;
+    char style;
+};
+
+// Scratch space for lexInline(), reused between lines so styling a line
+// does not allocate once the vectors have grown.
+struct InlineScratch
+{
+    std::vector<Delimiter> delimiters;
+    std::vector<InlineSpan> atoms;        // code spans and links
+    std::vector<InlineSpan> emphasis;     // innermost first
+    LinkMatcher links;
+};
+
+thread_local InlineScratch inlineScratch;
+
+inline bool isPunct(char c)
+{
+    return c != '\0' && strchr("!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~", c) != nullptr;
+}
+
+// Characters outside [s, e) count as whitespace, as at the ends of a line.
+inline bool isSpaceAt(const char* p, const char* s, const char* e)
+{
+    return p < s || p >= e || isBlank(*p);
+}
+
+inline bool isPunctAt(const char* p, const char* s, const char* e)
+{
+    return p >= s && p < e && isPunct(*p);
+}
+
+// Classify the run [p, p + n) as left- and right-flanking and add it to the
+// delimiter list, following the CommonMark rules for '*' and '_'. Only runs
+// of one or two '~' are strikethrough delimiters, as in GFM.
+void addDelimiter(std::vector<Delimiter>& delims, const char* p, int n, const char* s, const char* e)
+{
+    const char c = *p;
+    if (c == '~' && n > 2) return;
+
+    const char* before = p - 1;
+    const char* after = p + n;
+    const bool spaceBefore = isSpaceAt(before, s, e);
+    const bool spaceAfter = isSpaceAt(after, s, e);
+    const bool punctBefore = isPunctAt(before, s, e);
+    const bool punctAfter = isPunctAt(after, s, e);
+    const bool left = !spaceAfter && (!punctAfter || spaceBefore || punctBefore);
+    const bool right = !spaceBefore && (!punctBefore || spaceAfter || punctAfter);
+
+    Delimiter d;
+    d.pos = p;
+    d.length = n;
+    d.origLength = n;
+    d.c = c;
+    d.canOpen = (c == '_') ? left && (!right || punctBefore) : left;
+    d.canClose = (c == '_') ? right && (!left || punctAfter) : right;
+    if (!d.canOpen && !d.canClose) return;
+    d.prev = static_cast<int>(delims.size()) - 1;
+    d.next = -1;
+    if (d.prev >= 0) delims[d.prev].next = static_cast<int>(delims.size());
+    delims.push_back(d);
+}
+
+void unlinkDelimiter(std::vector<Delimiter>& delims, int i)
+{
+    const Delimiter& d = delims[i];
+    if (d.prev >= 0) delims[d.prev].next = d.next;
+    if (d.next >= 0) delims[d.next].prev = d.prev;
+}
+
+inline int delimiterSlot(char c)
+{
+    return (c == '*') ? 0 : (c == '_') ? 1 : 2;
+}
+
+// The CommonMark "process emphasis" procedure. Each closer searches back for
+// an opener, but never below the lowest opener an earlier closer of the same
+// kind already failed to reach, so the whole pass is linear in the number of
+// runs however many of them stay unmatched.
+void resolveEmphasis(std::vector<Delimiter>& delims, std::vector<InlineSpan>& spans)
+{
+    // Indexed by character, closer length mod 3 and whether the closer can
+    // also open.
+    int openersBottom[3][3][2];
+    for (auto& byChar : openersBottom) {
+        for (auto& byLength : byChar) byLength[0] = byLength[1] = -1;
+    }
+
+    int current = delims.empty() ? -1 : 0;
+    while (current >= 0) {
+        Delimiter& closer = delims[current];
+        if (!closer.canClose) {
+            current = closer.next;
+            continue;
+        }
+
+        int& bottom = openersBottom[delimiterSlot(closer.c)][closer.origLength % 3][closer.canOpen ? 1 : 0];
+        int opener = closer.prev;
+        for (; opener > bottom; opener = delims[opener].prev) {
+            const Delimiter& o = delims[opener];
+            if (o.c != closer.c || !o.canOpen) continue;
+            if (o.c == '~') {
+                if (o.length == closer.length) break;
+                continue;
+            }
+            // The "rule of 3": a run that can both open and close only pairs
+            // with one whose lengths do not sum to a multiple of 3.
+            const bool oddMatch = (o.canClose || closer.canOpen) &&
+                                  (o.origLength + closer.origLength) % 3 == 0 &&
+                                  !(o.origLength % 3 == 0 && closer.origLength % 3 == 0);
+            if (!oddMatch) break;
+        }
+
+        if (opener <= bottom) {
+            bottom = closer.prev;
+            const int next = closer.next;
+            if (!closer.canOpen) unlinkDelimiter(delims, current);
+            current = next;
+            continue;
+        }
+
+        Delimiter& o = delims[opener];
+        char style;
+        int use;
+        if (closer.c == '~') {
+            use = closer.length;
+            style = SCE_MARKDOWN_STRIKEOUT;
+        } else {
+            use = (o.length >= 2 && closer.length >= 2) ? 2 : 1;
+            if (use == 2) style = (closer.c == '*') ? SCE_MARKDOWN_STRONG1 : SCE_MARKDOWN_STRONG2;
+            else style = (closer.c == '*') ? SCE_MARKDOWN_EM1 : SCE_MARKDOWN_EM2;
+        }
+
+        // The opener gives up its innermost characters, the closer its first.
+        o.length -= use;
+        spans.push_back({ o.pos + o.length, closer.pos + use, style });
+        closer.pos += use;
+        closer.length -= use;
+
+        // Runs between the pair can no longer match anything.
+        o.next = current;
+        closer.prev = opener;
+        if (o.length == 0) unlinkDelimiter(delims, opener);
+        if (closer.length == 0) {
+            const int next = closer.next;
+            unlinkDelimiter(delims, current);
+            current = next;
+        }
+    }
+}
+
+// Style code spans, links and emphasis in [s, e). styles is aligned with base.
+// Code spans and links are found first and hide any delimiters inside them;
+// emphasis is painted outermost first so nested spans keep their own style.
+void lexInline(const char* s, const char* e, const char* base, char* styles)
+{
+    InlineScratch& scratch = inlineScratch;
+    scratch.delimiters.clear();
+    scratch.atoms.clear();
+    scratch.emphasis.clear();
+    scratch.links.reset(s, e);
+
+    const char* p = s;
+    while (p < e) {
+        const char c = *p;
+
+        if (c == '\\' && p + 1 < e) {
+            p += 2;
+            continue;
+        }
+
+        if (c == '`') {
+            const int n = runLength(p, e, '`');
+            const char* q = p + n;
+            const char* close = nullptr;
+            while (q < e) {
+                q = static_cast<const char*>(memchr(q, '`', e - q));
+                if (!q) break;
+                const int m = runLength(q, e, '`');
+                if (m == n) {
+                    close = q + m;
+                    break;
+                }
+                q += m;
+            }
+            if (close) {
+                scratch.atoms.push_back({ p, close, static_cast<char>((n == 1) ? SCE_MARKDOWN_CODE : SCE_MARKDOWN_CODE2) });
+                p = close;
+            } else {
+                p += n;
+            }
+            continue;
+        }
+
+        if (c == '[' || (c == '!' && p + 1 < e && p[1] == '[')) {
+            const char* linkEnd = scratch.links.match((c == '!') ? p + 1 : p, e);
+            if (linkEnd) {
+                scratch.atoms.push_back({ p, linkEnd, SCE_MARKDOWN_LINK });
+                p = linkEnd;
+                continue;
+            }
+        }
+
+        if (c == '<') {
+            const char* linkEnd = matchAutolink(p, e);
+            if (linkEnd) {
+                scratch.atoms.push_back({ p, linkEnd, SCE_MARKDOWN_LINK });
+                p = linkEnd;
+                continue;
+            }
+        }
+
+        if (c == '*' || c == '_' || c == '~') {
+            const int n = runLength(p, e, c);
+            addDelimiter(scratch.delimiters, p, n, s, e);
+            p += n;
+            continue;
+        }
+
+        p++;
+    }
+
+    resolveEmphasis(scratch.delimiters, scratch.emphasis);
+    for (auto it = scratch.emphasis.rbegin(); it != scratch.emphasis.rend(); ++it) {
+        fill(styles, base, it->from, it->to, it->style);
+    }
+    for (const InlineSpan& span : scratch.atoms) fill(styles, base, span.from, span.to, span.style);
+}
+
+// Columns of leading whitespace in [p, end), with tabs advancing to the
+// next multiple of 4. content receives the first non-blank character.
+int indentColumns(const char* p, const char* end, const char** content)
+{
+    int col = 0;
+    while (p < end && isBlank(*p)) {
+        col = (*p == '\t') ? (col + 4) & ~3 : col + 1;
+        p++;
+    }
+    *content = p;
+    return col;
+}
+
+const char* skipColumns(const char* p, const char* end, int columns)
+{
+    int col = 0;
+    while (p < end && col < columns && isBlank(*p)) {
+        col = (*p == '\t') ? (col + 4) & ~3 : col + 1;
+        p++;
+    }
+    return p;
+}
+
+// Skip up to maxDepth blockquote markers and return the content after them.
+const char* skipQuoteMarkers(const char* p, const char* end, int maxDepth, int& depth)
+{
+    depth = 0;
+    while (depth < maxDepth) {
+        const char* q = p;
+        int spaces = 0;
+        while (q < end && *q == ' ' && spaces < 3) {
+            q++;
+            spaces++;
+        }
+        if (q >= end || *q != '>') break;
+        q++;
+        if (q < end && isBlank(*q)) q++;
+        p = q;
+        depth++;
+    }
+    return p;
+}
+
+// A line that cannot start a block of its own continues an open paragraph.
+bool isLazyContinuation(const char* p, const char* end)
+{
+    const LineKind kind = lineKind(classifyLine(p, end));
+    return kind == LK_TEXT || kind == LK_INDENT;
+}
+
+// Front matter opens with "---" on the first line and closes with "---" or "...".
+bool isFrontMatterFence(const char* p, const char* end, bool closing)
+{
+    if (end - p < 3) return false;
+    if (memcmp(p, "---", 3) != 0 && !(closing && memcmp(p, "...", 3) == 0)) return false;
+    return onlyBlanks(p + 3, end);
+}
+
+bool startsWith(const char* p, const char* end, const char* word, bool ignoreCase)
+{
+    for (; *word; word++, p++) {
+        if (p >= end) return false;
+        char c = *p;
+        if (ignoreCase && c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c != *word) return false;
+    }
+    return true;
+}
+
+bool contains(const char* p, const char* end, const char* word, bool ignoreCase)
+{
+    for (; p < end; p++) {
+        if (startsWith(p, end, word, ignoreCase)) return true;
+    }
+    return false;
+}
+
+// Tag names that start an HTML block of kind 6, sorted for binary search.
+const char* const htmlBlockTags[] = {
+    "address", "article", "aside", "base", "basefont", "blockquote", "body",
+    "caption", "center", "col", "colgroup", "dd", "details", "dialog", "dir",
+    "div", "dl", "dt", "fieldset", "figcaption", "figure", "footer", "form",
+    "frame", "frameset", "h1", "h2", "h3", "h4", "h5", "h6", "head", "header",
+    "hr", "html", "iframe", "legend", "li", "link", "main", "menu", "menuitem",
+    "nav", "noframes", "ol", "optgroup", "option", "p", "param", "search",
+    "section", "summary", "table", "tbody", "td", "tfoot", "th", "thead",
+    "title", "tr", "track", "ul",
+};
+
+bool isHtmlBlockTag(const char* p, const char* end)
+{
+    const char* q = p;
+    while (q < end && isAlnum(*q)) q++;
+    const size_t n = static_cast<size_t>(q - p);
+    if (n == 0 || n > 10) return false;
+    if (q < end && !isBlank(*q) && *q != '>' && !(*q == '/' && q + 1 < end && q[1] == '>')) return false;
+
+    char name[11];
+    for (size_t i = 0; i < n; i++) {
+        name[i] = (p[i] >= 'A' && p[i] <= 'Z') ? static_cast<char>(p[i] + 'a' - 'A') : p[i];
+    }
+    name[n] = '\0';
+
+    size_t lo = 0;
+    size_t hi = sizeof(htmlBlockTags) / sizeof(htmlBlockTags[0]);
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const int cmp = strcmp(htmlBlockTags[mid], name);
+        if (cmp == 0) return true;
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return false;
+}
+
+// A complete open or closing tag with nothing else on the line.
+bool isCompleteTag(const char* p, const char* end)
+{
+    const char* q = p + 1;
+    if (q < end && *q == '/') q++;
+    if (q >= end || !isAlpha(*q)) return false;
+    while (q < end && (isAlnum(*q) || *q == '-')) q++;
+    char quote = 0;
+    for (; q < end; q++) {
+        if (quote) {
+            if (*q == quote) quote = 0;
+        } else if (*q == '"' || *q == '\'') {
+            quote = *q;
+        } else if (*q == '>') {
+            return onlyBlanks(q + 1, end);
+        } else if (*q == '<') {
+            return false;
+        }
+    }
+    return false;
+}
+
+// The CommonMark HTML block start conditions, numbered 1-7 as in the spec.
+// Returns 0 when the line does not open an HTML block.
+int htmlBlockKind(const char* p, const char* end, bool inParagraph)
+{
+    if (p >= end || *p != '<') return 0;
+    const char* q = p + 1;
+
+    static const char* const rawTags[] = { "script", "pre", "style", "textarea" };
+    for (const char* tag : rawTags) {
+        if (startsWith(q, end, tag, true)) {
+            const char* r = q + strlen(tag);
+            if (r == end || isBlank(*r) || *r == '>') return 1;
+        }
+    }
+    if (startsWith(q, end, "!--", false)) return 2;
+    if (q < end && *q == '?') return 3;
+    if (q + 1 < end && *q == '!' && isAlpha(q[1])) return 4;
+    if (startsWith(q, end, "![CDATA[", false)) return 5;
+    if (isHtmlBlockTag((q < end && *q == '/') ? q + 1 : q, end)) return 6;
+    if (!inParagraph && isCompleteTag(p, end)) return 7;
+    return 0;
+}
+
+// Length of the opening sequence of an HTML block, so its own closing
+// marker is not found inside it.
+int htmlOpenerLength(int kind)
+{
+    switch (kind) {
+    case 2: return 4;
+    case 3: return 2;
+    case 4: return 2;
+    case 5: return 9;
+    default: return 1;
+    }
+}
+
+// Kinds 1-5 end on the line containing their terminator; 6 and 7 end at a
+// blank line.
+bool htmlBlockEnds(int kind, const char* p, const char* end)
+{
+    switch (kind) {
+    case 1:
+        return contains(p, end, "</script>", true) || contains(p, end, "</pre>", true) ||
+               contains(p, end, "</style>", true) || contains(p, end, "</textarea>", true);
+    case 2: return contains(p, end, "-->", false);
+    case 3: return contains(p, end, "?>", false);
+    case 4: return memchr(p, '>', end - p) != nullptr;
+    case 5: return contains(p, end, "]]>", false);
+    default: return false;
+    }
+}
+
+void closeContainers(BlockState& st)
+{
+    st.mode = MDMODE_NORMAL;
+    st.fenceTilde = false;
+    st.arg = 0;
+    st.language = CODE_NONE;
+    st.code = CODESTATE_NONE;
+    st.listDepth = 0;
+    st.listIndent = 0;
+    st.paragraph = false;
+}
+
+// Columns from a list marker to the start of the item's content. Five or more
+// spaces mean indented code inside the item, which starts one column in.
+int listContentOffset(const LineClass& lc, const char* end)
+{
+    const char* q = lc.content + lc.marker;
+    int spaces = 0;
+    while (q < end && *q == ' ' && spaces < 5) {
+        q++;
+        spaces++;
+    }
+    if (spaces == 0 || spaces > 4 || q == end) spaces = 1;
+    return lc.marker + spaces;
+}
+
+// GFM table rows. Cells are split at unescaped pipes; a pipe at either end
+// of the row only closes the cell beside it.
+enum TableRow
+{
+    ROW_HEADER,
+    ROW_DELIMITER,
+    ROW_BODY
+};
+
+void trimBlanks(const char*& p, const char*& end)
+{
+    while (p < end && isBlank(*p)) p++;
+    while (end > p && isBlank(end[-1])) end--;
+}
+
+// A delimiter row cell: dashes with an optional alignment colon at each end.
+bool isDelimiterCell(const char* p, const char* end)
+{
+    trimBlanks(p, end);
+    if (p < end && *p == ':') p++;
+    if (end > p && end[-1] == ':') end--;
+    return p < end && runLength(p, end, '-') == end - p;
+}
+
+// The cells in a row that has at least one pipe, or 0. For a delimiter row
+// every cell must be a delimiter cell.
+int tableCells(const char* p, const char* end, bool delimiter)
+{
+    trimBlanks(p, end);
+    if (p == end) return 0;
+    bool pipe = *p == '|';
+    if (pipe) p++;
+    int cells = 0;
+    const char* cell = p;
+    for (const char* q = p;; q++) {
+        if (q < end && *q == '\\') {
+            if (q + 1 < end) q++;
+            continue;
+        }
+        if (q < end && *q != '|') continue;
+        if (q == end && cell == end && cells > 0) break;     // trailing pipe
+        if (delimiter && !isDelimiterCell(cell, q)) return 0;
+        cells++;
+        if (q == end) break;
+        pipe = true;
+        cell = q + 1;
+    }
+    return pipe ? cells : 0;
+}
+
+// Style a row. Body cells past the header's columns are not part of the
+// table and stay plain.
+void lexTableRow(const char* p, const char* end, TableRow row, int columns, const char* base, char* styles)
+{
+    trimBlanks(p, end);
+    if (p < end && *p == '|') {
+        fill(styles, base, p, p + 1, SCE_MARKDOWN_TABLE_PIPE);
+        p++;
+    }
+    int column = 0;
+    const char* cell = p;
+    for (const char* q = p; q <= end; q++) {
+        if (q < end && *q == '\\') {
+            if (q + 1 < end) q++;
+            continue;
+        }
+        if (q < end && *q != '|') continue;
+
+        const char* text = cell;
+        const char* textEnd = q;
+        trimBlanks(text, textEnd);
+        if (row == ROW_HEADER) {
+            fill(styles, base, text, textEnd, SCE_MARKDOWN_TABLE_HEADER);
+        } else if (row == ROW_DELIMITER) {
+            for (const char* c = text; c < textEnd; c++) {
+                styles[c - base] = (*c == ':') ? SCE_MARKDOWN_TABLE_ALIGN : SCE_MARKDOWN_TABLE_PIPE;
+            }
+        } else if (column < columns) {
+            lexInline(text, textEnd, base, styles);
+        }
+        if (q < end) fill(styles, base, q, q + 1, SCE_MARKDOWN_TABLE_PIPE);
+        column++;
+        cell = q + 1;
+    }
+}
+
+// The content of line inside the containers st holds open, or null when
+// the line is outside them.
+const char* containerContent(const Line& line, const BlockState& st)
+{
+    const char* p = line.begin;
+    if (st.quoteDepth > 0) {
+        int depth;
+        p = skipQuoteMarkers(p, line.end, st.quoteDepth, depth);
+        if (depth != st.quoteDepth) return nullptr;
+    }
+    if (st.listDepth > 0) {
+        const char* content;
+        if (indentColumns(p, line.end, &content) < st.listIndent) return nullptr;
+        p = skipColumns(p, line.end, st.listIndent);
+    }
+    return p;
+}
+
+// Style one line and return the state at its end. next is the following line,
+// if it is part of the text, and is only used to detect setext headings.
+int lexLine(const Line& line, unsigned char cls, const Line* next, int stateIn, bool firstLine,
+            const char* base, char* styles, LineFold& fold)
+{
+    BlockState st = BlockState::unpack(stateIn);
+
+    if (st.mode == MDMODE_FRONTMATTER) {
+        fill(styles, base, line.begin, line.next, SCE_MARKDOWN_CODEBK);
+        if (isFrontMatterFence(line.begin, line.end, true)) st.mode = MDMODE_NORMAL;
+        else lexCodeLine(CODE_YAML, CODESTATE_NONE, line.begin, line.end, base, styles);
+        return st.pack();
+    }
+    if (firstLine && isFrontMatterFence(line.begin, line.end, false)) {
+        fill(styles, base, line.begin, line.next, SCE_MARKDOWN_CODEBK);
+        BlockState frontMatter;
+        frontMatter.mode = MDMODE_FRONTMATTER;
+        return frontMatter.pack();
+    }
+
+    // Blockquote markers. Inside a fence or HTML block only the markers of
+    // the enclosing quotes are container syntax; the rest is content.
+    int quotes = 0;
+    const char* p = line.begin;
+    if (lineKind(cls) == LK_QUOTE) {
+        const int maxDepth = (st.mode == MDMODE_NORMAL) ? MDSTATE_QUOTE_MASK : st.quoteDepth;
+        p = skipQuoteMarkers(line.begin, line.end, maxDepth, quotes);
+    }
+
+    const bool blank = onlyBlanks(p, line.end);
+    bool lazy = false;
+    if (quotes > 0) {
+        if (quotes != st.quoteDepth) closeContainers(st);
+        st.quoteDepth = quotes;
+    } else if (st.quoteDepth > 0) {
+        if (st.mode == MDMODE_NORMAL && st.paragraph && !blank && isLazyContinuation(p, line.end)) {
+            lazy = true;
+        } else {
+            closeContainers(st);
+            st.quoteDepth = 0;
+        }
+    }
+
+    if (st.quoteDepth > 0) fill(styles, base, line.begin, line.next, SCE_MARKDOWN_BLOCKQUOTE);
+
+    // List items. Content indented to the innermost item belongs to it;
+    // anything less indented closes it, unless it continues a paragraph.
+    bool nested = false;
+    if (st.listDepth > 0 && !lazy && !blank) {
+        const char* content;
+        const int indent = indentColumns(p, line.end, &content);
+        if (indent >= st.listIndent) {
+            p = skipColumns(p, line.end, st.listIndent);
+            nested = true;
+        } else if (st.mode == MDMODE_NORMAL && st.paragraph && isLazyContinuation(p, line.end)) {
+            lazy = true;
+        } else {
+            const int depth = st.listDepth;
+            const int listIndent = st.listIndent;
+            closeContainers(st);
+            const LineKind kind = lineKind(classifyLine(p, line.end));
+            if (kind == LK_ULIST || kind == LK_OLIST) {
+                st.listDepth = depth;
+                st.listIndent = listIndent;
+            }
+        }
+    }
+
+    if (st.mode == MDMODE_FENCE) {
+        fill(styles, base, p, line.next, SCE_MARKDOWN_CODEBK);
+        const char* content;
+        const int indent = indentColumns(p, line.end, &content);
+        const char fenceChar = st.fenceTilde ? '~' : '`';
+        if (indent < 4 && content < line.end && *content == fenceChar) {
+            const int n = runLength(content, line.end, fenceChar);
+            if (n >= st.arg && onlyBlanks(content + n, line.end)) {
+                st.mode = MDMODE_NORMAL;
+                st.fenceTilde = false;
+                st.arg = 0;
+                st.language = CODE_NONE;
+                st.code = CODESTATE_NONE;
+                return st.pack();
+            }
+        }
+        if (st.language != CODE_NONE) {
+            st.code = lexCodeLine(static_cast<CodeLanguage>(st.language), st.code, p, line.end, base, styles);
+        }
+        return st.pack();
+    }
+
+    if (st.mode == MDMODE_HTML) {
+        if ((st.arg >= 6) ? blank : htmlBlockEnds(st.arg, p, line.end)) {
+            st.mode = MDMODE_NORMAL;
+            st.arg = 0;
+        }
+        return st.pack();
+    }
+
+    const unsigned char leaf = (p == line.begin) ? cls : classifyLine(p, line.end);
+    const LineClass lc = expandClass(p, line.end, leaf);
+    const bool prevParagraph = st.paragraph;
+    st.paragraph = false;
+
+    // A table runs from its header to a blank line or another block. Its
+    // column count is kept from the delimiter row, so no row looks back.
+    if (st.mode == MDMODE_TABLE) {
+        if (st.arg == 0) {
+            const int columns = tableCells(lc.content, line.end, true);
+            if (columns > 0) {
+                lexTableRow(lc.content, line.end, ROW_DELIMITER, columns, base, styles);
+                st.arg = columns;
+                return st.pack();
+            }
+        } else if (lc.kind == LK_TEXT) {
+            lexTableRow(lc.content, line.end, ROW_BODY, st.arg, base, styles);
+            return st.pack();
+        }
+        st.mode = MDMODE_NORMAL;
+        st.arg = 0;
+    }
+
+    if (lazy) {
+        lexInline(lc.content, line.end, base, styles);
+        st.paragraph = true;
+        return st.pack();
+    }
+
+    // Only top-level paragraphs become setext headings (see LK_TEXT below);
+    // under a list item or quote the line is a rule or more text.
+    const bool topLevel = st.quoteDepth == 0 && st.listDepth == 0;
+    if (prevParagraph && topLevel && lc.indent < 4 && setextLevel(p, line.end)) {
+        fill(styles, base, lc.content, line.end, SCE_MARKDOWN_LINE_BEGIN);
+        return st.pack();
+    }
+
+    switch (lc.kind) {
+    case LK_BLANK:
+        break;
+
+    case LK_INDENT:
+        if (prevParagraph) {
+            lexInline(lc.content, line.end, base, styles);
+            st.paragraph = true;
+        } else {
+            fill(styles, base, p, line.next, SCE_MARKDOWN_PRECHAR);
+        }
+        break;
+
+    case LK_ATX: {
+        const char* text = lc.content + lc.marker;
+        while (text < line.end && isBlank(*text)) text++;
+        const char* textEnd = line.end;
+        while (textEnd > text && isBlank(textEnd[-1])) textEnd--;
+        const char* closing = textEnd;
+        while (closing > text && closing[-1] == '#') closing--;
+        if (closing < textEnd && (closing == text || isBlank(closing[-1]))) textEnd = closing;
+        const char heading = static_cast<char>(SCE_MARKDOWN_HEADER1 + lc.marker - 1);
+        fill(styles, base, lc.content, text, SCE_MARKDOWN_LINE_BEGIN);
+        fill(styles, base, text, textEnd, heading);
+        fill(styles, base, textEnd, line.end, SCE_MARKDOWN_LINE_BEGIN);
+        fill(styles, base, line.end, line.next, heading);
+        if (st.quoteDepth == 0 && st.listDepth == 0) {
+            st.section = lc.marker;
+            fold.heading = lc.marker;
+        }
+        break;
+    }
+
+    case LK_FENCE:
+        fill(styles, base, p, line.next, SCE_MARKDOWN_CODEBK);
+        st.mode = MDMODE_FENCE;
+        st.fenceTilde = (*lc.content == '~');
+        st.arg = lc.marker;
+        st.language = codeLanguage(lc.content + lc.marker, line.end);
+        st.code = CODESTATE_NONE;
+        break;
+
+    case LK_QUOTE:
+        // A quote inside a list item; only top-level quotes are tracked.
+        fill(styles, base, p, line.next, SCE_MARKDOWN_BLOCKQUOTE);
+        lexInline(lc.content + 1, line.end, base, styles);
+        break;
+
+    case LK_HRULE:
+        fill(styles, base, lc.content, line.next, SCE_MARKDOWN_HRULE);
+        break;
+
+    case LK_ULIST:
+    case LK_OLIST: {
+        fill(styles, base, lc.content, lc.content + lc.marker,
+             (lc.kind == LK_ULIST) ? SCE_MARKDOWN_ULIST_ITEM : SCE_MARKDOWN_OLIST_ITEM);
+        lexInline(lc.content + lc.marker, line.end, base, styles);
+
+        // Only the innermost content column is kept, so a less indented
+        // marker is taken as a sibling when it is within a marker's width of
+        // that column and as the parent otherwise.
+        int column = lc.indent;
+        if (nested) {
+            column += st.listIndent;
+            st.listDepth++;
+        } else if (st.listDepth == 0 || column == 0) {
+            st.listDepth = 1;
+        } else if (column < st.listIndent - 3) {
+            st.listDepth--;
+        }
+        st.listIndent = column + listContentOffset(lc, line.end);
+        st.paragraph = true;
+        fold.item = true;
+        break;
+    }
+
+    case LK_TEXT:
+    default: {
+        const int kind = htmlBlockKind(lc.content, line.end, prevParagraph);
+        if (kind) {
+            if (kind >= 6 || !htmlBlockEnds(kind, lc.content + htmlOpenerLength(kind), line.end)) {
+                st.mode = MDMODE_HTML;
+                st.arg = kind;
+            }
+            break;
+        }
+
+        // A row with a pipe over a delimiter row with as many cells heads
+        // a table.
+        const char* delimiter = next ? containerContent(*next, st) : nullptr;
+        if (delimiter && memchr(lc.content, '|', line.end - lc.content)) {
+            const int columns = tableCells(lc.content, line.end, false);
+            if (columns > 0 && tableCells(delimiter, next->end, true) == columns) {
+                lexTableRow(lc.content, line.end, ROW_HEADER, columns, base, styles);
+                st.mode = MDMODE_TABLE;
+                st.arg = 0;
+                break;
+            }
+        }
+
+        const int level = (next && topLevel) ? setextLevel(next->begin, next->end) : 0;
+        if (level) {
+            const char heading = (level == 1) ? SCE_MARKDOWN_HEADER1 : SCE_MARKDOWN_HEADER2;
+            fill(styles, base, lc.content, line.next, heading);
+            st.section = level;
+            fold.heading = level;
+        } else {
+            lexInline(lc.content, line.end, base, styles);
+        }
+        st.paragraph = true;
+        break;
+    }
+    }
+
+    return st.pack();
+}
+
+// A line's fold depth: the level of the heading it is under, plus the
+// quotes and list items around it, plus one inside a fence. A heading, the
+// first line of a quote, a list marker and an opening fence sit one level
+// above the lines they fold.
+int foldDepth(int stateIn, int stateOut, const LineFold& fold)
+{
+    const BlockState before = BlockState::unpack(stateIn);
+    const BlockState after = BlockState::unpack(stateOut);
+    int depth = fold.heading ? fold.heading - 1 : after.section;
+    depth += std::min(before.quoteDepth, after.quoteDepth);
+    depth += fold.item ? after.listDepth - 1 : after.listDepth;
+    if (before.mode == MDMODE_FENCE || before.mode == MDMODE_FRONTMATTER) depth++;
+    return depth;
+}
+
+}
+
+void lexMarkdown(std::string_view text, int initialState, bool documentStart, LexOutput& out)
+{
+    out.styles.assign(text.size(), SCE_MARKDOWN_DEFAULT);
+    out.lineStates.clear();
+    out.foldDepths.clear();
+    classifyLines(text, out.lines);
+    if (text.empty()) return;
+
+    const char* const base = text.data();
+    char* const styles = &out.styles[0];
+    const size_t count = out.lines.count();
+    out.lineStates.reserve(count);
+    out.foldDepths.reserve(count);
+
+    int state = initialState;
+    Line line = lineAt(text, out.lines, 0);
+    for (size_t i = 0; i < count; i++) {
+        const bool hasNext = i + 1 < count;
+        Line next = line;
+        if (hasNext) next = lineAt(text, out.lines, i + 1);
+
+        LineFold fold;
+        const int stateIn = state;
+        state = lexLine(line, out.lines.classes[i], hasNext ? &next : nullptr, state,
+                        documentStart && i == 0, base, styles, fold);
+        out.lineStates.push_back(state);
+        out.foldDepths.push_back(static_cast<unsigned char>(foldDepth(stateIn, state, fold)));
+        line = next;
+    }
+}
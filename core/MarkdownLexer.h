@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LineClassifier.h"
+
+// Line state stored with SCI_SETLINESTATE for every line. It is the state at
+// the end of the line, packed from BlockState, so lexing can restart on the
+// next line without looking further back.
+#define MDMODE_NORMAL 0
+#define MDMODE_FENCE 1                  // fenced code block
+#define MDMODE_HTML 2                   // HTML block
+#define MDMODE_FRONTMATTER 3            // YAML front matter at the top of the file
+#define MDMODE_TABLE 4                  // GFM table
+
+#define MDSTATE_MODE_MASK 0x7
+#define MDSTATE_FENCE_TILDE 0x8         // fence was opened with ~ rather than `
+#define MDSTATE_ARG_SHIFT 4             // fence length (capped), HTML block kind or table columns
+#define MDSTATE_ARG_MASK 0x1F
+#define MDSTATE_QUOTE_SHIFT 9           // blockquote depth
+#define MDSTATE_QUOTE_MASK 0xF
+#define MDSTATE_LIST_SHIFT 13           // list nesting depth
+#define MDSTATE_LIST_MASK 0xF
+#define MDSTATE_INDENT_SHIFT 17         // content column of the innermost list item
+#define MDSTATE_INDENT_MASK 0x3F
+#define MDSTATE_PARAGRAPH 0x800000      // line was paragraph text
+#define MDSTATE_SECTION_SHIFT 24        // level of the last top-level heading
+#define MDSTATE_SECTION_MASK 0x7
+#define MDSTATE_LANGUAGE_SHIFT 27       // CodeLanguage of the fence
+#define MDSTATE_LANGUAGE_MASK 0x7
+#define MDSTATE_CODE_SHIFT 30           // CODESTATE_* of the code inside it
+#define MDSTATE_CODE_MASK 0x3
+
+// The container stack at the end of a line. Only the innermost list item's
+// content column fits in the packed state, so list nesting is tracked as a
+// depth plus that column.
+struct BlockState
+{
+    int mode = MDMODE_NORMAL;
+    bool fenceTilde = false;
+    int arg = 0;            // fence length, HTML block kind or table columns
+    int quoteDepth = 0;
+    int listDepth = 0;
+    int listIndent = 0;
+    bool paragraph = false;
+    int section = 0;
+    int language = 0;
+    int code = 0;
+
+    static BlockState unpack(int state)
+    {
+        BlockState st;
+        st.mode = state & MDSTATE_MODE_MASK;
+        st.fenceTilde = (state & MDSTATE_FENCE_TILDE) != 0;
+        st.arg = (state >> MDSTATE_ARG_SHIFT) & MDSTATE_ARG_MASK;
+        st.quoteDepth = (state >> MDSTATE_QUOTE_SHIFT) & MDSTATE_QUOTE_MASK;
+        st.listDepth = (state >> MDSTATE_LIST_SHIFT) & MDSTATE_LIST_MASK;
+        st.listIndent = (state >> MDSTATE_INDENT_SHIFT) & MDSTATE_INDENT_MASK;
+        st.paragraph = (state & MDSTATE_PARAGRAPH) != 0;
+        st.section = (state >> MDSTATE_SECTION_SHIFT) & MDSTATE_SECTION_MASK;
+        st.language = (state >> MDSTATE_LANGUAGE_SHIFT) & MDSTATE_LANGUAGE_MASK;
+        st.code = (static_cast<unsigned>(state) >> MDSTATE_CODE_SHIFT) & MDSTATE_CODE_MASK;
+        return st;
+    }
+
+    int pack() const
+    {
+        return (mode & MDSTATE_MODE_MASK) |
+               (fenceTilde ? MDSTATE_FENCE_TILDE : 0) |
+               (clamp(arg, MDSTATE_ARG_MASK) << MDSTATE_ARG_SHIFT) |
+               (clamp(quoteDepth, MDSTATE_QUOTE_MASK) << MDSTATE_QUOTE_SHIFT) |
+               (clamp(listDepth, MDSTATE_LIST_MASK) << MDSTATE_LIST_SHIFT) |
+               (clamp(listIndent, MDSTATE_INDENT_MASK) << MDSTATE_INDENT_SHIFT) |
+               (paragraph ? MDSTATE_PARAGRAPH : 0) |
+               (clamp(section, MDSTATE_SECTION_MASK) << MDSTATE_SECTION_SHIFT) |
+               (clamp(language, MDSTATE_LANGUAGE_MASK) << MDSTATE_LANGUAGE_SHIFT) |
+               static_cast<int>(static_cast<unsigned>(clamp(code, MDSTATE_CODE_MASK)) << MDSTATE_CODE_SHIFT);
+    }
+
+private:
+    static int clamp(int value, int mask) { return value < mask ? value : mask; }
+};
+
+struct LexOutput
+{
+    std::string styles;             // one style byte per input byte
+    std::vector<int> lineStates;    // state at the end of each line
+    std::vector<unsigned char> foldDepths;  // fold depth of each line
+    LineTable lines;                // block pre-pass over the same text
+};
+
+// Style text, which must begin at a line start. initialState is the state
+// stored for the line before it; documentStart is set when text begins at
+// the top of the document, where front matter may open.
+void lexMarkdown(std::string_view text, int initialState, bool documentStart, LexOutput& out);
+
+// Finds the links of one span of inline text. The brackets and parentheses
+// of the span are paired in a single pass with a stack, the first time a
+// link is asked for, so each link is then a lookup. Scanning ahead from
+// each [ instead costs time quadratic in the length of a line full of them.
+class LinkMatcher
+{
+public:
+    void reset(const char* begin, const char* end);
+
+    // The end of [text](url) or [text][ref] starting at the '[' at p, or
+    // nullptr when there is none before end. p and end lie within the span.
+    const char* match(const char* p, const char* end);
+
+private:
+    static constexpr uint32_t unpaired = UINT32_MAX;
+
+    void pair();
+
+    const char* begin_ = nullptr;
+    const char* end_ = nullptr;
+    bool paired_ = false;
+    std::vector<uint32_t> partner_;     // by offset: where a [ or ( closes
+    std::vector<uint32_t> brackets_;    // open while pairing
+    std::vector<uint32_t> parens_;
+};
+
+// The end of an autolink such as <https://example.com> starting at '<';
+// nullptr when there is none before end.
+const char* matchAutolink(const char* p, const char* end);
@@ -0,0 +1,41 @@
+#pragma once
+
+// Markdown lexer styles
+// The numbering matches Notepad++'s built-in Markdown lexer so style settings
+// written for either lexer keep working.
+#define SCE_MARKDOWN_DEFAULT 0
+#define SCE_MARKDOWN_LINE_BEGIN 1
+#define SCE_MARKDOWN_STRONG1 2
+#define SCE_MARKDOWN_STRONG2 3
+#define SCE_MARKDOWN_EM1 4
+#define SCE_MARKDOWN_EM2 5
+#define SCE_MARKDOWN_HEADER1 6
+#define SCE_MARKDOWN_HEADER2 7
+#define SCE_MARKDOWN_HEADER3 8
+#define SCE_MARKDOWN_HEADER4 9
+#define SCE_MARKDOWN_HEADER5 10
+#define SCE_MARKDOWN_HEADER6 11
+#define SCE_MARKDOWN_PRECHAR 12
+#define SCE_MARKDOWN_ULIST_ITEM 13
+#define SCE_MARKDOWN_OLIST_ITEM 14
+#define SCE_MARKDOWN_BLOCKQUOTE 15
+#define SCE_MARKDOWN_STRIKEOUT 16
+#define SCE_MARKDOWN_HRULE 17
+#define SCE_MARKDOWN_LINK 18
+#define SCE_MARKDOWN_CODE 19
+#define SCE_MARKDOWN_CODE2 20
+#define SCE_MARKDOWN_CODEBK 21
+
+// Code in a fenced block whose info string names a known language, in the
+// slots after the built-in lexer's. The rest of the block stays CODEBK.
+#define SCE_MARKDOWN_CODE_KEYWORD 22
+#define SCE_MARKDOWN_CODE_STRING 23
+#define SCE_MARKDOWN_CODE_COMMENT 24
+#define SCE_MARKDOWN_CODE_NUMBER 25
+#define SCE_MARKDOWN_CODE_PREPROC 26    // preprocessor lines, shell variables, YAML anchors and tags
+#define SCE_MARKDOWN_CODE_KEY 27        // JSON and YAML keys
+
+// GFM tables.
+#define SCE_MARKDOWN_TABLE_PIPE 28      // cell separators and the delimiter row's dashes
+#define SCE_MARKDOWN_TABLE_HEADER 29    // header row cells
+#define SCE_MARKDOWN_TABLE_ALIGN 30     // alignment colons in the delimiter row
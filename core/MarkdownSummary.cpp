@@ -0,0 +1,225 @@
+#include "MarkdownSummary.h"
+#include "BlockTree.h"
+#include "HeadingIndex.h"
+#include "MarkdownStyles.h"
+
+#include <unordered_map>
+
+namespace {
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+inline bool isWordByte(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+inline bool isCodeStyle(char style)
+{
+    return style == SCE_MARKDOWN_CODE || style == SCE_MARKDOWN_CODE2 || style == SCE_MARKDOWN_CODEBK ||
+           (style >= SCE_MARKDOWN_CODE_KEYWORD && style <= SCE_MARKDOWN_CODE_KEY);
+}
+
+// Lines in these modes hold no Markdown of their own.
+inline bool isVerbatim(int state)
+{
+    const int mode = state & MDSTATE_MODE_MASK;
+    return mode == MDMODE_FENCE || mode == MDMODE_HTML || mode == MDMODE_FRONTMATTER;
+}
+
+struct SummaryScratch
+{
+    LexOutput lexed;
+    BlockTree tree;
+    std::unordered_map<std::string, int> anchors;
+    LinkMatcher links;
+};
+
+thread_local SummaryScratch summaryScratch;
+
+// The closing ] of the link text opened at p.
+const char* linkTextEnd(const char* p, const char* end)
+{
+    int depth = 0;
+    for (; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '[') {
+            depth++;
+        } else if (*p == ']') {
+            if (--depth == 0) return p;
+        }
+    }
+    return end;
+}
+
+// The destination in (target "title"), or in <target>.
+std::string_view destination(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p)) p++;
+    if (p < end && *p == '<') {
+        const char* q = ++p;
+        while (q < end && *q != '>') q++;
+        return std::string_view(p, q - p);
+    }
+    const char* q = p;
+    while (q < end && !isBlank(*q)) q++;
+    return std::string_view(p, q - p);
+}
+
+class Summarizer
+{
+public:
+    Summarizer(std::string_view text, const LexOutput& lexed, LinkMatcher& links, MarkdownSummary& out)
+        : text_(text), lexed_(lexed), links_(links), out_(out)
+    {
+    }
+
+    void run()
+    {
+        bool definitions = false;       // the line before was a reference definition
+        for (size_t line = 0; line < lexed_.lines.count(); line++) {
+            const int state = lexed_.lineStates[line];
+            if (isVerbatim(state)) {
+                definitions = false;
+                continue;
+            }
+            const char* begin = text_.data() + lexed_.lines.starts[line];
+            const char* end = text_.data() + lineEnd(line);
+            const int before = (line > 0) ? lexed_.lineStates[line - 1] : 0;
+            const bool startsBlock = definitions || ((before & MDSTATE_PARAGRAPH) == 0 && !isVerbatim(before));
+            definitions = startsBlock && readDefinition(static_cast<int>(line), begin, end);
+            if (definitions) continue;
+            links_.reset(begin, end);
+            scanLinks(static_cast<int>(line), begin, begin, end);
+            countWords(begin, end);
+        }
+    }
+
+private:
+    size_t lineEnd(size_t line) const
+    {
+        size_t end = (line + 1 < lexed_.lines.count()) ? lexed_.lines.starts[line + 1] : text_.size();
+        while (end > lexed_.lines.starts[line] && (text_[end - 1] == '\n' || text_[end - 1] == '\r')) end--;
+        return end;
+    }
+
+    char styleAt(const char* p) const { return lexed_.styles[p - text_.data()]; }
+
+    // [label]: target, with up to three blanks before it. Footnotes,
+    // [^label]:, are not references.
+    bool readDefinition(int line, const char* p, const char* end)
+    {
+        const char* lineStart = p;
+        while (p < end && isBlank(*p) && p - lineStart < 3) p++;
+        if (p == end || *p != '[' || isCodeStyle(styleAt(p))) return false;
+        const char* close = linkTextEnd(p, end);
+        if (close >= end || close == p + 1 || p[1] == '^' || close + 1 >= end || close[1] != ':') return false;
+        const std::string_view target = destination(close + 2, end);
+        if (target.empty()) return false;
+        out_.references.push_back({ line, std::string(p + 1, close), std::string(target) });
+        return true;
+    }
+
+    // Links in [p, end), including the ones inside another link's text,
+    // such as an image that is itself a link.
+    void scanLinks(int line, const char* lineStart, const char* p, const char* end)
+    {
+        while (p < end) {
+            const char c = *p;
+            if ((c != '[' && c != '<') || isCodeStyle(styleAt(p))) {
+                p += (c == '\\') ? 2 : 1;
+                continue;
+            }
+            const int column = static_cast<int>(p - lineStart);
+            if (c == '<') {
+                const char* linkEnd = matchAutolink(p, end);
+                if (linkEnd) {
+                    out_.links.push_back({ line, column, LINK_AUTOLINK, std::string(p + 1, linkEnd - 1) });
+                    p = linkEnd;
+                } else {
+                    p++;
+                }
+                continue;
+            }
+            const char* linkEnd = links_.match(p, end);
+            if (!linkEnd) {
+                p++;
+                continue;
+            }
+            const char* textEnd = linkTextEnd(p, linkEnd);
+            if (textEnd[1] == '(') {
+                out_.links.push_back({ line, column, LINK_INLINE, std::string(destination(textEnd + 2, linkEnd - 1)) });
+            } else {
+                // [label][] uses the text as its label.
+                const bool collapsed = linkEnd - textEnd == 3;
+                const char* label = collapsed ? p + 1 : textEnd + 2;
+                const char* labelEnd = collapsed ? textEnd : linkEnd - 1;
+                out_.links.push_back({ line, column, LINK_REFERENCE, std::string(label, labelEnd) });
+            }
+            scanLinks(line, lineStart, p + 1, textEnd);
+            p = linkEnd;
+        }
+    }
+
+    void countWords(const char* p, const char* end)
+    {
+        bool inWord = false;
+        for (; p < end; p++) {
+            const bool word = isWordByte(*p) && !isCodeStyle(styleAt(p));
+            if (word && !inWord) out_.words++;
+            inWord = word;
+        }
+    }
+
+    std::string_view text_;
+    const LexOutput& lexed_;
+    LinkMatcher& links_;
+    MarkdownSummary& out_;
+};
+
+// Top-level headings, as HeadingIndex reads them, numbered the way GitHub
+// numbers repeated anchors.
+void collectHeadings(std::string_view text, const LexOutput& lexed, BlockTree& tree,
+                     std::unordered_map<std::string, int>& anchors, std::vector<SummaryHeading>& headings)
+{
+    tree.build(lexed);
+    anchors.clear();
+    for (const BlockNode* node = tree.root()->firstChild; node; node = node->next) {
+        if (node->kind != BLOCK_HEADING) continue;
+        const size_t begin = lexed.lines.starts[node->firstLine];
+        const std::pair<size_t, size_t> span = headingTextSpan(text, begin, node->lastLine - node->firstLine + 1);
+        SummaryHeading heading;
+        heading.line = node->firstLine;
+        heading.level = node->level;
+        heading.text.assign(text.substr(span.first, span.second - span.first));
+        heading.anchor = headingSlug(heading.text);
+        const int repeats = anchors[heading.anchor]++;
+        if (repeats > 0) heading.anchor += "-" + std::to_string(repeats);
+        headings.push_back(std::move(heading));
+    }
+    tree.clear();
+}
+
+}
+
+void MarkdownSummary::clear()
+{
+    headings.clear();
+    links.clear();
+    references.clear();
+    words = 0;
+}
+
+void summarizeMarkdown(std::string_view text, MarkdownSummary& out)
+{
+    out.clear();
+    SummaryScratch& scratch = summaryScratch;
+    lexMarkdown(text, 0, true, scratch.lexed);
+    collectHeadings(text, scratch.lexed, scratch.tree, scratch.anchors, out.headings);
+    Summarizer(text, scratch.lexed, scratch.links, out).run();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum LinkKind
+{
+    LINK_INLINE,        // [text](target) or ![alt](target)
+    LINK_REFERENCE,     // [text][label] or [label][]; the target is the label
+    LINK_AUTOLINK       // <scheme:target>
+};
+
+// A top-level heading and its anchor, with the -1, -2 suffix GitHub gives
+// repeats.
+struct SummaryHeading
+{
+    int line;
+    int level;
+    std::string text;
+    std::string anchor;
+};
+
+struct SummaryLink
+{
+    int line;
+    int column;             // bytes from the start of the line to the [ or <
+    LinkKind kind;
+    std::string target;     // as written, without <> or a title
+};
+
+// A reference definition, [label]: target.
+struct SummaryReference
+{
+    int line;
+    std::string label;
+    std::string target;
+};
+
+// What the workspace index keeps of one Markdown file.
+struct MarkdownSummary
+{
+    std::vector<SummaryHeading> headings;
+    std::vector<SummaryLink> links;
+    std::vector<SummaryReference> references;
+    uint32_t words = 0;     // runs of letters and digits outside code
+
+    void clear();
+};
+
+// Lex text, a whole document, and collect its headings, links, reference
+// definitions and words. Code spans and blocks, HTML blocks and front
+// matter are skipped.
+void summarizeMarkdown(std::string_view text, MarkdownSummary& out);
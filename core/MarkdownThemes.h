@@ -0,0 +1,95 @@
+#pragma once
+
+#include "StylePalette.h"
+
+// Style tables for light and dark editor backgrounds, picked from the
+// brightness of STYLE_DEFAULT's background. Both must set the same fields of
+// each style; see haveSameFields().
+
+#define CODE_FONT "Consolas"
+
+inline constexpr Theme lightTheme = {
+    { SCE_MARKDOWN_DEFAULT, NO_COLOUR, NO_COLOUR, 0, 0, nullptr },
+    // Line begin (# symbols themselves)
+    { SCE_MARKDOWN_LINE_BEGIN, rgb(160, 160, 170), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    // Bold text (**text** or __text__)
+    { SCE_MARKDOWN_STRONG1, rgb(200, 0, 20), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_STRONG2, rgb(200, 0, 20), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    // Italic text (*text* or _text_)
+    { SCE_MARKDOWN_EM1, rgb(20, 140, 40), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    { SCE_MARKDOWN_EM2, rgb(20, 140, 40), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    // H1 24pt down to H6 14pt, all bold
+    { SCE_MARKDOWN_HEADER1, rgb(220, 20, 60), NO_COLOUR, STYLEFLAG_BOLD, 24, nullptr },     // Crimson Red
+    { SCE_MARKDOWN_HEADER2, rgb(30, 144, 255), NO_COLOUR, STYLEFLAG_BOLD, 22, nullptr },    // Dodger Blue
+    { SCE_MARKDOWN_HEADER3, rgb(34, 139, 34), NO_COLOUR, STYLEFLAG_BOLD, 20, nullptr },     // Forest Green
+    { SCE_MARKDOWN_HEADER4, rgb(255, 140, 0), NO_COLOUR, STYLEFLAG_BOLD, 18, nullptr },     // Dark Orange
+    { SCE_MARKDOWN_HEADER5, rgb(138, 43, 226), NO_COLOUR, STYLEFLAG_BOLD, 16, nullptr },    // Blue Violet
+    { SCE_MARKDOWN_HEADER6, rgb(178, 34, 34), NO_COLOUR, STYLEFLAG_BOLD, 14, nullptr },     // Firebrick
+    // Prechar (indented code blocks)
+    { SCE_MARKDOWN_PRECHAR, rgb(199, 37, 78), rgb(245, 245, 248), 0, 0, CODE_FONT },
+    // Unordered (-, *, +) and ordered (1., 2.) list items
+    { SCE_MARKDOWN_ULIST_ITEM, rgb(0, 120, 215), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    { SCE_MARKDOWN_OLIST_ITEM, rgb(0, 120, 215), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    // Block quotes (> text)
+    { SCE_MARKDOWN_BLOCKQUOTE, rgb(100, 100, 110), rgb(250, 250, 245), STYLEFLAG_ITALIC | STYLEFLAG_EOLFILLED, 0, nullptr },
+    // Strikethrough (~~text~~)
+    { SCE_MARKDOWN_STRIKEOUT, rgb(130, 130, 140), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    // Horizontal rules (---, ***, ___)
+    { SCE_MARKDOWN_HRULE, rgb(180, 180, 190), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    // Links [text](url)
+    { SCE_MARKDOWN_LINK, rgb(0, 102, 204), NO_COLOUR, STYLEFLAG_UNDERLINE, 0, nullptr },
+    // Inline code (`code` and ``code``)
+    { SCE_MARKDOWN_CODE, rgb(199, 37, 78), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE2, rgb(199, 37, 78), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    // Code blocks (```code```)
+    { SCE_MARKDOWN_CODEBK, rgb(70, 70, 80), rgb(245, 245, 248), STYLEFLAG_EOLFILLED, 10, CODE_FONT },
+    // Code in fenced blocks of a known language
+    { SCE_MARKDOWN_CODE_KEYWORD, rgb(0, 0, 200), rgb(245, 245, 248), STYLEFLAG_BOLD, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_STRING, rgb(163, 21, 21), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_COMMENT, rgb(0, 128, 0), rgb(245, 245, 248), STYLEFLAG_ITALIC, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_NUMBER, rgb(9, 134, 88), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_PREPROC, rgb(128, 64, 0), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_KEY, rgb(4, 81, 165), rgb(245, 245, 248), 0, 10, CODE_FONT },
+    // Tables (| a | b |)
+    { SCE_MARKDOWN_TABLE_PIPE, rgb(160, 160, 170), NO_COLOUR, 0, 0, nullptr },
+    { SCE_MARKDOWN_TABLE_HEADER, rgb(40, 40, 50), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_TABLE_ALIGN, rgb(0, 120, 215), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+};
+
+inline constexpr Theme darkTheme = {
+    { SCE_MARKDOWN_DEFAULT, NO_COLOUR, NO_COLOUR, 0, 0, nullptr },
+    { SCE_MARKDOWN_LINE_BEGIN, rgb(100, 100, 110), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_STRONG1, rgb(255, 130, 140), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_STRONG2, rgb(255, 130, 140), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_EM1, rgb(130, 220, 150), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    { SCE_MARKDOWN_EM2, rgb(130, 220, 150), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    { SCE_MARKDOWN_HEADER1, rgb(255, 105, 120), NO_COLOUR, STYLEFLAG_BOLD, 24, nullptr },
+    { SCE_MARKDOWN_HEADER2, rgb(100, 180, 255), NO_COLOUR, STYLEFLAG_BOLD, 22, nullptr },
+    { SCE_MARKDOWN_HEADER3, rgb(100, 220, 130), NO_COLOUR, STYLEFLAG_BOLD, 20, nullptr },
+    { SCE_MARKDOWN_HEADER4, rgb(255, 180, 80), NO_COLOUR, STYLEFLAG_BOLD, 18, nullptr },
+    { SCE_MARKDOWN_HEADER5, rgb(200, 130, 255), NO_COLOUR, STYLEFLAG_BOLD, 16, nullptr },
+    { SCE_MARKDOWN_HEADER6, rgb(255, 130, 90), NO_COLOUR, STYLEFLAG_BOLD, 14, nullptr },
+    { SCE_MARKDOWN_PRECHAR, rgb(255, 150, 200), rgb(50, 50, 55), 0, 0, CODE_FONT },
+    { SCE_MARKDOWN_ULIST_ITEM, rgb(120, 200, 255), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    { SCE_MARKDOWN_OLIST_ITEM, rgb(120, 200, 255), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    { SCE_MARKDOWN_BLOCKQUOTE, rgb(180, 180, 190), rgb(45, 45, 50), STYLEFLAG_ITALIC | STYLEFLAG_EOLFILLED, 0, nullptr },
+    { SCE_MARKDOWN_STRIKEOUT, rgb(140, 140, 150), NO_COLOUR, STYLEFLAG_ITALIC, 0, nullptr },
+    { SCE_MARKDOWN_HRULE, rgb(120, 120, 130), NO_COLOUR, STYLEFLAG_BOLD, 12, nullptr },
+    { SCE_MARKDOWN_LINK, rgb(100, 180, 255), NO_COLOUR, STYLEFLAG_UNDERLINE, 0, nullptr },
+    { SCE_MARKDOWN_CODE, rgb(255, 150, 200), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE2, rgb(255, 150, 200), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODEBK, rgb(210, 210, 220), rgb(50, 50, 55), STYLEFLAG_EOLFILLED, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_KEYWORD, rgb(86, 156, 214), rgb(50, 50, 55), STYLEFLAG_BOLD, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_STRING, rgb(206, 145, 120), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_COMMENT, rgb(106, 153, 85), rgb(50, 50, 55), STYLEFLAG_ITALIC, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_NUMBER, rgb(181, 206, 168), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_PREPROC, rgb(197, 134, 192), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_CODE_KEY, rgb(156, 220, 254), rgb(50, 50, 55), 0, 10, CODE_FONT },
+    { SCE_MARKDOWN_TABLE_PIPE, rgb(120, 120, 130), NO_COLOUR, 0, 0, nullptr },
+    { SCE_MARKDOWN_TABLE_HEADER, rgb(230, 230, 235), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+    { SCE_MARKDOWN_TABLE_ALIGN, rgb(86, 156, 214), NO_COLOUR, STYLEFLAG_BOLD, 0, nullptr },
+};
+
+static_assert(isValidTheme(lightTheme), "lightTheme entries must follow SCE_MARKDOWN_* order");
+static_assert(isValidTheme(darkTheme), "darkTheme entries must follow SCE_MARKDOWN_* order");
+static_assert(haveSameFields(lightTheme, darkTheme), "lightTheme and darkTheme must set the same fields");
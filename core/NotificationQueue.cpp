@@ -0,0 +1,54 @@
+#include "NotificationQueue.h"
+
+void LatencyStats::add(double ms)
+{
+    count++;
+    totalMs += ms;
+    if (ms > maxMs) maxMs = ms;
+}
+
+bool NotificationQueue::post(uintptr_t bufferId, PendingKind kind, double nowMs)
+{
+    const bool wasEmpty = pending_.empty();
+    const unsigned bit = 1u << kind;
+
+    // Bursts touch a handful of buffers, so a linear search is enough.
+    for (PendingBuffer& p : pending_) {
+        if (p.bufferId != bufferId) continue;
+        coalesced_++;
+        if (!(p.kinds & bit)) {
+            p.kinds |= bit;
+            p.postedMs[kind] = nowMs;
+        }
+        return wasEmpty;
+    }
+
+    PendingBuffer p;
+    p.bufferId = bufferId;
+    p.kinds = bit;
+    p.postedMs[kind] = nowMs;
+    pending_.push_back(p);
+    return wasEmpty;
+}
+
+bool NotificationQueue::take(uintptr_t shownBuffer, PendingBuffer& shown)
+{
+    bool found = false;
+    for (const PendingBuffer& p : pending_) {
+        if (p.bufferId == shownBuffer) {
+            shown = p;
+            found = true;
+        } else {
+            dropped_++;
+        }
+    }
+    pending_.clear();
+    return found;
+}
+
+void NotificationQueue::recordApplied(const PendingBuffer& applied, double nowMs)
+{
+    for (int kind = 0; kind < PENDING_KIND_COUNT; kind++) {
+        if (applied.kinds & (1u << kind)) latency_[kind].add(nowMs - applied.postedMs[kind]);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Notifications after which the styles have to be applied again.
+enum PendingKind
+{
+    PENDING_OPENED,
+    PENDING_ACTIVATED,
+    PENDING_SAVED,
+    PENDING_KIND_COUNT
+};
+
+// Time from a notification to the styles being applied for it.
+struct LatencyStats
+{
+    unsigned count = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+
+    void add(double ms);
+    double averageMs() const { return count ? totalMs / count : 0; }
+};
+
+// The notifications waiting for one buffer. postedMs holds the time of the
+// first notification of each kind in kinds.
+struct PendingBuffer
+{
+    uintptr_t bufferId = 0;
+    unsigned kinds = 0;
+    double postedMs[PENDING_KIND_COUNT] = {};
+};
+
+// Holds buffer notifications until the plugin gets round to them, so a burst
+// of open, activate and save notifications, such as a session restore, ends
+// in one styling pass for the buffer on screen. Times are in milliseconds
+// from any fixed origin; the caller supplies the clock.
+class NotificationQueue
+{
+public:
+    // Record a notification. Returns true when the queue was empty, so the
+    // caller knows to schedule a drain.
+    bool post(uintptr_t bufferId, PendingKind kind, double nowMs);
+
+    // Empty the queue. Returns true, with its notifications in shown, when
+    // shownBuffer had any; the other buffers are dropped, since they get a
+    // new activation when they are shown.
+    bool take(uintptr_t shownBuffer, PendingBuffer& shown);
+
+    // Record the latency of every notification in applied.
+    void recordApplied(const PendingBuffer& applied, double nowMs);
+
+    void clear() { pending_.clear(); }
+    bool empty() const { return pending_.empty(); }
+
+    const LatencyStats& latency(PendingKind kind) const { return latency_[kind]; }
+
+    // Notifications merged into an earlier one for the same buffer.
+    unsigned coalesced() const { return coalesced_; }
+
+    // Buffers whose notifications were dropped because another was shown.
+    unsigned dropped() const { return dropped_; }
+
+private:
+    std::vector<PendingBuffer> pending_;
+    LatencyStats latency_[PENDING_KIND_COUNT];
+    unsigned coalesced_ = 0;
+    unsigned dropped_ = 0;
+};
@@ -0,0 +1,172 @@
+#include "ParallelLexer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace {
+
+// Partitions are at least this long, so a thread has enough to do.
+const size_t minPartitionBytes = 1024 * 1024;
+
+// How far past a split target to look for a boundary, in lines.
+const size_t boundarySearchLines = 4096;
+
+// Lines re-lexed at a time while a partition with the wrong start state
+// catches up with its speculative result.
+const size_t repairSliceLines = 256;
+
+// The state a partition is assumed to start in: after a blank line at the top
+// level, outside any container or fence.
+const int partitionState = 0;
+
+struct Partition
+{
+    size_t firstLine;
+    size_t endLine;                 // one past the last line
+    LexOutput out;
+};
+
+// Pick the lines partitions start on. A boundary is the line after a blank
+// line with an even number of fence lines above it, which is outside any
+// fence unless fences are nested or unbalanced. An ATX heading there closes
+// every list and quote as well, so one is preferred; otherwise any line
+// starting at the margin will do. A wrong guess costs a repair, not output.
+std::vector<size_t> findBoundaries(const LineTable& lines, size_t textSize, size_t partitions)
+{
+    const size_t count = lines.count();
+    std::vector<size_t> boundaries;
+    size_t line = 0;
+    bool evenFences = true;
+    for (size_t p = 1; p < partitions; p++) {
+        const size_t target = textSize / partitions * p;
+        for (; line < count && lines.starts[line] < target; line++) {
+            if (lineKind(lines.classes[line]) == LK_FENCE) evenFences = !evenFences;
+        }
+
+        size_t fallback = 0;
+        size_t chosen = 0;
+        const size_t limit = std::min(count, line + boundarySearchLines);
+        bool even = evenFences;
+        for (size_t i = line; i + 1 < limit; i++) {
+            const LineKind kind = lineKind(lines.classes[i]);
+            if (kind == LK_FENCE) even = !even;
+            if (kind != LK_BLANK || !even) continue;
+            const LineKind next = lineKind(lines.classes[i + 1]);
+            if (next == LK_ATX) {
+                chosen = i + 1;
+                break;
+            }
+            if (!fallback && next != LK_BLANK && next != LK_INDENT && next != LK_FENCE) fallback = i + 1;
+        }
+        if (!chosen) chosen = fallback;
+        if (!chosen) continue;
+
+        for (; line < chosen; line++) {
+            if (lineKind(lines.classes[line]) == LK_FENCE) evenFences = !evenFences;
+        }
+        boundaries.push_back(chosen);
+    }
+    return boundaries;
+}
+
+size_t lineOffset(const LineTable& lines, size_t line, size_t textSize)
+{
+    return (line < lines.count()) ? lines.starts[line] : textSize;
+}
+
+// Re-lex a partition from its real start state, a slice at a time, until a
+// line ends in the state the speculative pass gave it; every line after that
+// keeps the speculative styles. Returns the line to copy from.
+size_t repairPartition(std::string_view text, const LineTable& lines, Partition& part, int state, LexOutput& out)
+{
+    LexOutput slice;
+    size_t line = part.firstLine;
+    while (line < part.endLine) {
+        // Lex one line past the slice for the setext lookahead. The partition
+        // ends on a blank line, so its last line needs none.
+        const size_t sliceEnd = std::min(part.endLine, line + repairSliceLines);
+        const size_t lexEnd = std::min(part.endLine, sliceEnd + 1);
+        const size_t from = lines.starts[line];
+        const size_t to = lineOffset(lines, lexEnd, text.size());
+        lexMarkdown(text.substr(from, to - from), state, false, slice);
+
+        const size_t kept = std::min(sliceEnd - line, slice.lineStates.size());
+        if (kept == 0) break;
+        for (size_t k = 0; k < kept; k++) {
+            out.lineStates[line + k] = slice.lineStates[k];
+            out.foldDepths[line + k] = slice.foldDepths[k];
+            const size_t begin = lines.starts[line + k];
+            const size_t end = lineOffset(lines, line + k + 1, text.size());
+            memcpy(&out.styles[begin], &slice.styles[begin - from], end - begin);
+            if (slice.lineStates[k] == part.out.lineStates[line + k - part.firstLine]) return line + k + 1;
+        }
+        line += kept;
+        state = slice.lineStates[kept - 1];
+    }
+    return part.endLine;
+}
+
+}
+
+void lexMarkdownParallel(std::string_view text, int initialState, bool documentStart, LexOutput& out,
+                         ThreadPool& pool)
+{
+    const size_t partitions = std::min<size_t>(pool.concurrency(), text.size() / minPartitionBytes);
+    if (partitions < 2 || text.size() < parallelLexThreshold) {
+        lexMarkdown(text, initialState, documentStart, out);
+        return;
+    }
+
+    classifyLines(text, out.lines);
+    const LineTable& lines = out.lines;
+    const std::vector<size_t> boundaries = findBoundaries(lines, text.size(), partitions);
+    if (boundaries.empty()) {
+        lexMarkdown(text, initialState, documentStart, out);
+        return;
+    }
+
+    std::vector<Partition> parts(boundaries.size() + 1);
+    for (size_t p = 0; p < parts.size(); p++) {
+        parts[p].firstLine = (p == 0) ? 0 : boundaries[p - 1];
+        parts[p].endLine = (p < boundaries.size()) ? boundaries[p] : lines.count();
+    }
+
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(parts.size());
+    for (size_t p = 0; p < parts.size(); p++) {
+        tasks.push_back([&, p] {
+            Partition& part = parts[p];
+            const size_t from = lines.starts[part.firstLine];
+            const size_t to = lineOffset(lines, part.endLine, text.size());
+            lexMarkdown(text.substr(from, to - from), (p == 0) ? initialState : partitionState,
+                        documentStart && p == 0, part.out);
+        });
+    }
+    pool.run(tasks);
+
+    // Stitch the partitions in order. Each seam is checked against the state
+    // the partition before it really ended in.
+    out.styles.resize(text.size());
+    out.lineStates.resize(lines.count());
+    out.foldDepths.resize(lines.count());
+    for (size_t p = 0; p < parts.size(); p++) {
+        Partition& part = parts[p];
+        size_t copyFrom = part.firstLine;
+        if (p > 0) {
+            const int seamState = out.lineStates[part.firstLine - 1];
+            if (seamState != partitionState) copyFrom = repairPartition(text, lines, part, seamState, out);
+        }
+        if (copyFrom >= part.endLine) continue;
+
+        const size_t base = lines.starts[part.firstLine];
+        const size_t from = lines.starts[copyFrom];
+        const size_t to = lineOffset(lines, part.endLine, text.size());
+        memcpy(&out.styles[from], &part.out.styles[from - base], to - from);
+        std::copy(part.out.lineStates.begin() + (copyFrom - part.firstLine), part.out.lineStates.end(),
+                  out.lineStates.begin() + copyFrom);
+        std::copy(part.out.foldDepths.begin() + (copyFrom - part.firstLine), part.out.foldDepths.end(),
+                  out.foldDepths.begin() + copyFrom);
+    }
+}
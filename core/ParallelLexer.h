@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string_view>
+
+#include "MarkdownLexer.h"
+
+class ThreadPool;
+
+// Text shorter than this is lexed on the calling thread alone.
+const size_t parallelLexThreshold = 4 * 1024 * 1024;
+
+// Same contract and output as lexMarkdown(), but large text is split into
+// partitions at blank lines that look like top-level block boundaries, and
+// the partitions are lexed on the pool. A partition that turns out to start
+// in a different state than assumed is re-lexed from the real state until it
+// rejoins the speculative result, so the output always matches lexMarkdown().
+void lexMarkdownParallel(std::string_view text, int initialState, bool documentStart, LexOutput& out,
+                         ThreadPool& pool);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+
+#include "../plugin/Scintilla.h"
+
+// Sends messages to one Scintilla view. Everything the plugin asks of a view
+// goes through this, so the same code runs against a fake view on Linux.
+class ScintillaCall
+{
+public:
+    virtual ~ScintillaCall() = default;
+    virtual sptr_t call(unsigned int message, uptr_t wParam = 0, sptr_t lParam = 0) = 0;
+};
+
+// Calls the view's direct function, fetched once with SCI_GETDIRECTFUNCTION
+// and SCI_GETDIRECTPOINTER, instead of going through the window procedure.
+// The status variant (SCI_GETDIRECTSTATUSFUNCTION) also reports SCI_GETSTATUS
+// for each call. Like SendMessage, it may only be used on the view's thread.
+class DirectScintillaCall : public ScintillaCall
+{
+public:
+    DirectScintillaCall() = default;
+    DirectScintillaCall(SciFnDirect fn, sptr_t ptr) : fn_(fn), ptr_(ptr) {}
+    DirectScintillaCall(SciFnDirectStatus fn, sptr_t ptr) : statusFn_(fn), ptr_(ptr) {}
+
+    bool valid() const { return ptr_ && (fn_ || statusFn_); }
+
+    // Status of the last call; always 0 without the status variant.
+    int status() const { return status_; }
+
+    sptr_t call(unsigned int message, uptr_t wParam = 0, sptr_t lParam = 0) override
+    {
+        if (statusFn_) return statusFn_(ptr_, message, wParam, lParam, &status_);
+        return fn_(ptr_, message, wParam, lParam);
+    }
+
+private:
+    SciFnDirect fn_ = nullptr;
+    SciFnDirectStatus statusFn_ = nullptr;
+    sptr_t ptr_ = 0;
+    int status_ = 0;
+};
+
+// A fake view that counts the messages sent to it. Replies come from reply,
+// or are 0 when it is not set.
+class RecordingScintillaCall : public ScintillaCall
+{
+public:
+    std::function<sptr_t(unsigned int, uptr_t, sptr_t)> reply;
+
+    sptr_t call(unsigned int message, uptr_t wParam = 0, sptr_t lParam = 0) override
+    {
+        counts_[message]++;
+        total_++;
+        return reply ? reply(message, wParam, lParam) : 0;
+    }
+
+    unsigned count(unsigned int message) const
+    {
+        const auto it = counts_.find(message);
+        return (it != counts_.end()) ? it->second : 0;
+    }
+
+    unsigned total() const { return total_; }
+
+    void reset()
+    {
+        counts_.clear();
+        total_ = 0;
+    }
+
+private:
+    std::unordered_map<unsigned int, unsigned> counts_;
+    unsigned total_ = 0;
+};
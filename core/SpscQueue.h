@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Keeps data written by different threads on different cache lines.
+const size_t cacheLineSize = 64;
+
+// A bounded queue between exactly one producer thread and one consumer
+// thread, without locks. Each index is written by one side only and sits on
+// its own cache line, next to that side's copy of the other index, so each
+// side only reads the shared index when the queue looks full or empty.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer only. Returns false, leaving value alone, when the queue is
+    // full. idle is set when the consumer had emptied the queue before this
+    // push, so it may have stopped draining and needs waking.
+    bool push(T&& value, bool* idle = nullptr)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == Capacity) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == Capacity) return false;
+        }
+        slots_[tail & (Capacity - 1)] = std::move(value);
+
+        // Sequentially consistent, with the same in pop(): either the
+        // consumer sees this item or the producer sees the consumer's last
+        // pop and reports it idle, so no wake-up is lost.
+        tail_.store(tail + 1, std::memory_order_seq_cst);
+        if (idle) {
+            headCache_ = head_.load(std::memory_order_seq_cst);
+            *idle = (headCache_ == tail);
+        }
+        return true;
+    }
+
+    // Consumer only. Returns false when the queue is empty.
+    bool pop(T& value)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_seq_cst);
+            if (head == tailCache_) return false;
+        }
+        value = std::move(slots_[head & (Capacity - 1)]);
+        head_.store(head + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Either side; only a hint while the other side is running.
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(cacheLineSize) std::atomic<size_t> tail_{0};   // next slot to fill
+    size_t headCache_ = 0;                                  // producer's copy of head_
+    alignas(cacheLineSize) std::atomic<size_t> head_{0};   // next slot to empty
+    size_t tailCache_ = 0;                                  // consumer's copy of tail_
+    alignas(cacheLineSize) T slots_[Capacity];
+};
@@ -0,0 +1,27 @@
+#include "StylePalette.h"
+
+#include <cstring>
+
+void applyTheme(ScintillaCall& scintilla, ViewStyles* view, const Theme& theme)
+{
+    const StyleDescriptor* known = view ? view->theme : nullptr;
+    if (known == theme) return;
+
+    for (int style = 0; style < MARKDOWN_STYLE_COUNT; style++) {
+        const StyleDescriptor& d = theme[style];
+        const StyleDescriptor* had = known ? &known[style] : nullptr;
+
+        if (d.fore != NO_COLOUR && (!had || had->fore != d.fore)) scintilla.call(SCI_STYLESETFORE, style, d.fore);
+        if (d.back != NO_COLOUR && (!had || had->back != d.back)) scintilla.call(SCI_STYLESETBACK, style, d.back);
+        if (d.size && (!had || had->size != d.size)) scintilla.call(SCI_STYLESETSIZE, style, d.size);
+        if (d.font && (!had || !had->font || strcmp(had->font, d.font) != 0)) {
+            scintilla.call(SCI_STYLESETFONT, style, reinterpret_cast<sptr_t>(d.font));
+        }
+        if (had) continue;   // themes set the same flags
+        if (d.flags & STYLEFLAG_BOLD) scintilla.call(SCI_STYLESETBOLD, style, 1);
+        if (d.flags & STYLEFLAG_ITALIC) scintilla.call(SCI_STYLESETITALIC, style, 1);
+        if (d.flags & STYLEFLAG_UNDERLINE) scintilla.call(SCI_STYLESETUNDERLINE, style, 1);
+        if (d.flags & STYLEFLAG_EOLFILLED) scintilla.call(SCI_STYLESETEOLFILLED, style, 1);
+    }
+    if (view) view->theme = theme;
+}
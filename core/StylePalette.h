@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MarkdownStyles.h"
+#include "ScintillaCall.h"
+
+const int MARKDOWN_STYLE_COUNT = SCE_MARKDOWN_TABLE_ALIGN + 1;
+
+// Colours are Scintilla's 0xBBGGRR, the same layout as a Windows COLORREF.
+constexpr uint32_t rgb(int r, int g, int b)
+{
+    return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16);
+}
+
+// Marks a colour the style leaves as STYLE_DEFAULT has it.
+constexpr uint32_t NO_COLOUR = 0xFFFFFFFF;
+
+// Attributes a style turns on. STYLE_DEFAULT has them all off, so only set
+// flags are sent.
+#define STYLEFLAG_BOLD 0x01
+#define STYLEFLAG_ITALIC 0x02
+#define STYLEFLAG_UNDERLINE 0x04
+#define STYLEFLAG_EOLFILLED 0x08
+
+// One entry of a theme table. Fields left at their unset value (NO_COLOUR, no
+// flag, size 0, no font) keep what STYLE_DEFAULT gives the style and cost no
+// message.
+struct StyleDescriptor
+{
+    int style;              // the SCE_MARKDOWN_* the entry is for
+    uint32_t fore;
+    uint32_t back;
+    unsigned flags;         // STYLEFLAG_*
+    int size;               // points
+    const char* font;
+};
+
+// A theme table lists every Markdown style, in SCE_MARKDOWN_* order.
+typedef StyleDescriptor Theme[MARKDOWN_STYLE_COUNT];
+
+// Compile-time checks for a theme table: every entry sits at the index of its
+// style, flags and sizes are in range.
+constexpr bool isValidTheme(const Theme& theme)
+{
+    for (int i = 0; i < MARKDOWN_STYLE_COUNT; i++) {
+        const StyleDescriptor& d = theme[i];
+        if (d.style != i) return false;
+        if (d.flags & ~(STYLEFLAG_BOLD | STYLEFLAG_ITALIC | STYLEFLAG_UNDERLINE | STYLEFLAG_EOLFILLED)) return false;
+        if (d.size < 0 || d.size > 72) return false;
+        if (d.fore != NO_COLOUR && d.fore > 0xFFFFFF) return false;
+        if (d.back != NO_COLOUR && d.back > 0xFFFFFF) return false;
+    }
+    return true;
+}
+
+// Themes applied one after another must set the same fields of each style,
+// or a field one of them sets would outlive it.
+constexpr bool haveSameFields(const Theme& a, const Theme& b)
+{
+    for (int i = 0; i < MARKDOWN_STYLE_COUNT; i++) {
+        if ((a[i].fore == NO_COLOUR) != (b[i].fore == NO_COLOUR)) return false;
+        if ((a[i].back == NO_COLOUR) != (b[i].back == NO_COLOUR)) return false;
+        if (a[i].flags != b[i].flags) return false;
+        if ((a[i].size == 0) != (b[i].size == 0)) return false;
+        if ((a[i].font == nullptr) != (b[i].font == nullptr)) return false;
+    }
+    return true;
+}
+
+// The theme last applied to a view. Notepad++ rewrites the styles when it
+// installs its own lexer, on SCI_STYLECLEARALL, and when the theme or the
+// Style Configurator changes them; theme is cleared whenever that can have
+// happened.
+struct ViewStyles
+{
+    const StyleDescriptor* theme = nullptr;
+};
+
+// Send the fields of theme that differ from the theme view is known to hold,
+// and record it. With no record, or a null view, every set field is sent.
+void applyTheme(ScintillaCall& scintilla, ViewStyles* view, const Theme& theme);
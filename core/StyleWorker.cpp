@@ -0,0 +1,86 @@
+#include "StyleWorker.h"
+#include "MarkdownFolding.h"
+#include "ParallelLexer.h"
+#include "ThreadPool.h"
+
+void StyleWorker::submit(TaskScheduler::BufferId buffer, StyleJob&& job)
+{
+    buffer_ = buffer;
+    std::shared_ptr<StyleJob> shared = std::make_shared<StyleJob>(std::move(job));
+    scheduler_.post(buffer, JOB_LEX, [this, shared](const CancelToken& token) { lex(*shared, token); });
+}
+
+void StyleWorker::cancel()
+{
+    scheduler_.cancel(buffer_, JOB_LEX);
+}
+
+bool StyleWorker::take(StyleResult& result)
+{
+    bool found = false;
+    std::unique_ptr<StyleResult> queued;
+    while (results_.pop(queued)) {
+        if (!queued->token.cancelled()) {
+            std::swap(result, *queued);
+            found = true;
+        }
+        // The buffers go back to the workers; if they have enough, they are freed.
+        spares_.push(std::move(queued));
+    }
+    return found;
+}
+
+void StyleWorker::lex(StyleJob& job, const CancelToken& token)
+{
+    std::unique_ptr<StyleResult> result;
+    {
+        std::lock_guard<std::mutex> lock(workerSide_);
+        spares_.pop(result);
+    }
+    if (!result) result.reset(new StyleResult);
+    result->version = job.version;
+    result->token = token;
+    result->startPos = job.startPos;
+    result->firstLine = job.firstLine;
+    result->committedLines = 0;
+    // A job can be tens of megabytes, a long batch for the pool the UI
+    // thread's lexer waits on, so it is split across the background pool.
+    lexMarkdownParallel(job.text, job.initialState, job.firstLine == 0, result->out, ThreadPool::background());
+
+    // A result superseded while it was lexed is not worth queueing, and one
+    // that does not fit is dropped: the UI thread is not keeping up and
+    // would throw it away as stale anyway.
+    if (token.cancelled()) return;
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> lock(workerSide_);
+        if (!results_.push(std::move(result), &idle)) return;
+    }
+    if (idle && wake_) wake_();
+}
+
+size_t commitStyleRun(ScintillaCall& scintilla, StyleResult& result, size_t maxBytes)
+{
+    const LineTable& lines = result.out.lines;
+    const size_t first = result.committedLines;
+    const size_t count = result.out.lineStates.size();
+    if (first >= count) return 0;
+
+    size_t last = first + 1;
+    const size_t from = lines.starts[first];
+    while (last < count && lines.starts[last] - from < maxBytes) last++;
+    const size_t to = (last < count) ? lines.starts[last] : result.out.styles.size();
+
+    scintilla.call(SCI_STARTSTYLING, result.startPos + from);
+    scintilla.call(SCI_SETSTYLINGEX, to - from, reinterpret_cast<sptr_t>(result.out.styles.data() + from));
+    for (size_t line = first; line < last; line++) {
+        scintilla.call(SCI_SETLINESTATE, result.firstLine + line, result.out.lineStates[line]);
+    }
+    Sci_Position lineCount = scintilla.call(SCI_GETLINECOUNT);
+    if (lineCount > 1 && scintilla.call(SCI_POSITIONFROMLINE, lineCount - 1) == scintilla.call(SCI_GETLENGTH)) lineCount--;
+    updateFoldLevels(result.out, first, last, result.firstLine, lineCount,
+                     [&](Sci_Position line) { return static_cast<int>(scintilla.call(SCI_GETFOLDLEVEL, line)); },
+                     [&](Sci_Position line, int level) { scintilla.call(SCI_SETFOLDLEVEL, line, level); });
+    result.committedLines = last;
+    return last - first;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../plugin/ILexer.h"
+#include "MarkdownLexer.h"
+#include "ScintillaCall.h"
+#include "SpscQueue.h"
+#include "TaskScheduler.h"
+
+// Lines of a document to lex away from the UI thread. text is a copy of
+// them, taken when the document was at version; it starts at a line start.
+struct StyleJob
+{
+    uint64_t version = 0;
+    Sci_Position startPos = 0;
+    Sci_Position firstLine = 0;
+    int initialState = 0;           // state of the line before firstLine
+    std::string text;
+};
+
+// The shadow styles and line states for a finished job, waiting to be
+// committed to the view.
+struct StyleResult
+{
+    uint64_t version = 0;
+    CancelToken token;              // of the job it came from
+    Sci_Position startPos = 0;
+    Sci_Position firstLine = 0;
+    LexOutput out;
+    size_t committedLines = 0;      // lines already sent to the view
+
+    bool committed() const { return committedLines >= out.lineStates.size(); }
+};
+
+// Lexes jobs on the scheduler as the buffer's JOB_LEX job, so a new job,
+// or anything that cancels the buffer's jobs, supersedes the last one. The
+// result of a superseded job is thrown away. Results reach the UI thread
+// through a lock-free queue, so taking them never waits for a worker.
+class StyleWorker
+{
+public:
+    // wake is called on a worker thread when a result is queued and the UI
+    // thread had taken everything before it.
+    explicit StyleWorker(TaskScheduler& scheduler, std::function<void()> wake = nullptr)
+        : scheduler_(scheduler), wake_(std::move(wake)) {}
+
+    StyleWorker(const StyleWorker&) = delete;
+    StyleWorker& operator=(const StyleWorker&) = delete;
+
+    void submit(TaskScheduler::BufferId buffer, StyleJob&& job);
+
+    // Cancel the last job submitted.
+    void cancel();
+
+    // Move the latest finished result into result, skipping stale ones.
+    // Returns false when there is none. UI thread only.
+    bool take(StyleResult& result);
+
+private:
+    void lex(StyleJob& job, const CancelToken& token);
+
+    TaskScheduler& scheduler_;
+    std::function<void()> wake_;
+    TaskScheduler::BufferId buffer_ = 0;    // of the last job submitted
+
+    // Results travel to the UI thread and their buffers come back to be
+    // reused, each way through its own queue. A superseded job can still be
+    // finishing when the next one does, so the workers take turns at their
+    // end of the queues; the UI thread never takes the lock.
+    std::mutex workerSide_;
+    SpscQueue<std::unique_ptr<StyleResult>, 4> results_;
+    SpscQueue<std::unique_ptr<StyleResult>, 4> spares_;
+};
+
+// Send the next run of a result to the view: one SCI_STARTSTYLING and one
+// SCI_SETSTYLINGEX for whole lines totalling about maxBytes, then the line
+// states and changed fold levels of those lines. Returns the number of
+// lines sent.
+size_t commitStyleRun(ScintillaCall& scintilla, StyleResult& result, size_t maxBytes);
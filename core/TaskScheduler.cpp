@@ -0,0 +1,189 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+
+TaskScheduler::~TaskScheduler()
+{
+    stop();
+}
+
+unsigned TaskScheduler::defaultWorkers()
+{
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return std::max(1u, std::min(4u, hardware / 2));
+}
+
+CancelToken TaskScheduler::post(BufferId buffer, JobKind kind, Task task)
+{
+    Job job;
+    job.buffer = buffer;
+    job.kind = kind;
+    job.task = std::move(task);
+    const CancelToken token = job.token;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (threads_.empty()) {
+            stopping_ = false;
+            for (unsigned i = 0; i < workerCount_; i++) queues_.emplace_back(new WorkerQueue);
+            for (unsigned i = 0; i < workerCount_; i++) threads_.emplace_back(&TaskScheduler::workerLoop, this, i);
+        }
+
+        auto it = current_.find(std::make_pair(buffer, static_cast<int>(kind)));
+        if (it != current_.end()) {
+            const CancelToken superseded = it->second;
+            superseded.cancel();
+            dropQueued([&](const Job& queued) { return queued.token == superseded; });
+            it->second = token;
+        } else {
+            current_.emplace(std::make_pair(buffer, static_cast<int>(kind)), token);
+        }
+
+        WorkerQueue& queue = (buffer == activeBuffer_) ? active_ : *queues_[nextQueue_++ % queues_.size()];
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+        queued_++;
+    }
+    wake_.notify_one();
+    return token;
+}
+
+void TaskScheduler::cancel(BufferId buffer, JobKind kind)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = current_.find(std::make_pair(buffer, static_cast<int>(kind)));
+    if (it == current_.end()) return;
+    const CancelToken token = it->second;
+    token.cancel();
+    dropQueued([&](const Job& queued) { return queued.token == token; });
+    current_.erase(it);
+}
+
+void TaskScheduler::cancelBuffer(BufferId buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int kind = 0; kind < JOB_KIND_COUNT; kind++) {
+        auto it = current_.find(std::make_pair(buffer, kind));
+        if (it == current_.end()) continue;
+        it->second.cancel();
+        current_.erase(it);
+    }
+    dropQueued([&](const Job& queued) { return queued.buffer == buffer; });
+}
+
+void TaskScheduler::setActiveBuffer(BufferId buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffer == activeBuffer_) return;
+    activeBuffer_ = buffer;
+
+    // Jobs queued for the previous active buffer go back to the worker
+    // queues, behind the jobs already there, and the new one's take their
+    // place ahead of the others.
+    std::lock_guard<std::mutex> activeLock(active_.mutex);
+    if (queues_.empty()) return;
+    for (Job& job : active_.jobs) {
+        WorkerQueue& queue = *queues_[nextQueue_++ % queues_.size()];
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    active_.jobs.clear();
+    for (std::unique_ptr<WorkerQueue>& queue : queues_) {
+        std::lock_guard<std::mutex> queueLock(queue->mutex);
+        auto moved = std::stable_partition(queue->jobs.begin(), queue->jobs.end(),
+                                           [&](const Job& job) { return job.buffer != buffer; });
+        std::move(moved, queue->jobs.end(), std::back_inserter(active_.jobs));
+        queue->jobs.erase(moved, queue->jobs.end());
+    }
+}
+
+void TaskScheduler::stop()
+{
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& entry : current_) entry.second.cancel();
+        current_.clear();
+        dropQueued([](const Job&) { return true; });
+        threads.swap(threads_);
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads) thread.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    queues_.clear();
+}
+
+size_t TaskScheduler::queued()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_;
+}
+
+// Remove matching jobs from every queue. Called with mutex_ held.
+void TaskScheduler::dropQueued(const std::function<bool(const Job&)>& match)
+{
+    auto drop = [&](WorkerQueue& queue) {
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        const size_t before = queue.jobs.size();
+        queue.jobs.erase(std::remove_if(queue.jobs.begin(), queue.jobs.end(), match), queue.jobs.end());
+        queued_ -= before - queue.jobs.size();
+    };
+    drop(active_);
+    for (std::unique_ptr<WorkerQueue>& queue : queues_) drop(*queue);
+}
+
+// Take the next job for worker index: the active buffer's first, then the
+// oldest in the worker's own queue, then the newest in another worker's.
+bool TaskScheduler::takeJob(size_t index, Job& job)
+{
+    auto takeFront = [&](WorkerQueue& queue) {
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        if (queue.jobs.empty()) return false;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    };
+    auto takeBack = [&](WorkerQueue& queue) {
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        if (queue.jobs.empty()) return false;
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        return true;
+    };
+
+    if (takeFront(active_) || takeFront(*queues_[index])) return true;
+    for (size_t i = 1; i < queues_.size(); i++) {
+        if (takeBack(*queues_[(index + i) % queues_.size()])) return true;
+    }
+    return false;
+}
+
+void TaskScheduler::finished(const Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = current_.find(std::make_pair(job.buffer, static_cast<int>(job.kind)));
+    if (it != current_.end() && it->second == job.token) current_.erase(it);
+}
+
+void TaskScheduler::workerLoop(size_t index)
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || queued_ > 0; });
+            if (stopping_) return;
+        }
+
+        Job job;
+        if (!takeJob(index, job)) continue;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_--;
+        }
+
+        if (!job.token.cancelled()) job.task(job.token);
+        finished(job);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Background work the plugin does per buffer. A buffer has at most one job
+// of each kind; posting another supersedes it.
+enum JobKind
+{
+    JOB_LEX,
+    JOB_INDEX,
+    JOB_LINT,
+    JOB_KIND_COUNT
+};
+
+// Shared between a job and the scheduler, and set once the job is cancelled
+// or superseded. A job that is still queued then never runs; one that is
+// running should poll cancelled() and return early.
+class CancelToken
+{
+public:
+    CancelToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    bool cancelled() const { return flag_->load(std::memory_order_acquire); }
+    void cancel() const { flag_->store(true, std::memory_order_release); }
+
+    bool operator==(const CancelToken& other) const { return flag_ == other.flag_; }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+// Runs jobs keyed by buffer ID (NPPM_GETCURRENTBUFFERID) on a few worker
+// threads. Every worker has its own queue and steals from the others when
+// it runs dry. Jobs for the active buffer go to a queue that every worker
+// checks first, so a session restore full of background buffers cannot
+// hold up the one on screen.
+class TaskScheduler
+{
+public:
+    typedef uintptr_t BufferId;
+    typedef std::function<void(const CancelToken&)> Task;
+
+    explicit TaskScheduler(unsigned workers = defaultWorkers()) : workerCount_(workers ? workers : 1) {}
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    // Queue a job, superseding the buffer's job of the same kind. The
+    // workers start on the first post.
+    CancelToken post(BufferId buffer, JobKind kind, Task task);
+
+    void cancel(BufferId buffer, JobKind kind);
+    void cancelBuffer(BufferId buffer);
+
+    // Jobs for buffer, queued now or later, run ahead of all others.
+    void setActiveBuffer(BufferId buffer);
+
+    // Cancel everything and join the workers. A later post() starts them again.
+    void stop();
+
+    // Jobs queued and not yet started.
+    size_t queued();
+
+    static unsigned defaultWorkers();
+
+private:
+    struct Job
+    {
+        BufferId buffer = 0;
+        JobKind kind = JOB_LEX;
+        CancelToken token;
+        Task task;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void workerLoop(size_t index);
+    bool takeJob(size_t index, Job& job);
+    void dropQueued(const std::function<bool(const Job&)>& match);
+    void finished(const Job& job);
+
+    const unsigned workerCount_;
+    std::vector<std::thread> threads_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    WorkerQueue active_;                // jobs for the active buffer
+    size_t nextQueue_ = 0;              // round robin for other buffers
+
+    std::mutex mutex_;                  // guards everything below
+    std::condition_variable wake_;
+    size_t queued_ = 0;
+    bool stopping_ = false;
+    BufferId activeBuffer_ = 0;
+    std::map<std::pair<BufferId, int>, CancelToken> current_;   // latest job per buffer and kind
+};
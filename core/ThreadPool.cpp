@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) workers_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+unsigned ThreadPool::defaultThreads()
+{
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return (hardware > 1) ? hardware - 1 : 0;
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool& ThreadPool::background()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::run(const std::vector<std::function<void()>>& tasks)
+{
+    if (tasks.empty()) return;
+
+    std::lock_guard<std::mutex> submit(submitMutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    batch_ = &tasks;
+    next_ = 0;
+    finished_ = 0;
+    generation_++;
+    wake_.notify_all();
+
+    runTasks(lock);
+    done_.wait(lock, [&] { return finished_ == tasks.size(); });
+    batch_ = nullptr;
+}
+
+// Take tasks from the current batch until none are left. Called with the
+// lock held; it is released while a task runs.
+void ThreadPool::runTasks(std::unique_lock<std::mutex>& lock)
+{
+    while (batch_ && next_ < batch_->size()) {
+        const std::function<void()>& task = (*batch_)[next_++];
+        lock.unlock();
+        task();
+        lock.lock();
+        if (++finished_ == batch_->size()) done_.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    unsigned seen = generation_;
+    for (;;) {
+        wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+        if (stopping_) return;
+        seen = generation_;
+        runTasks(lock);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run batches of tasks. The thread that
+// submits a batch works on it too and returns once every task has finished.
+class ThreadPool
+{
+public:
+    // threads is the number of workers besides the caller; by default one
+    // fewer than the hardware threads.
+    explicit ThreadPool(unsigned threads = defaultThreads());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads a batch runs on, counting the caller.
+    unsigned concurrency() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Run every task and wait for all of them. Batches from different
+    // threads run one after another.
+    void run(const std::vector<std::function<void()>>& tasks);
+
+    // A pool for the lexer Scintilla calls, created on first use. The UI
+    // thread lexes large documents on it, so nothing that runs long batches
+    // may use it.
+    static ThreadPool& shared();
+
+    // A pool for background work with long batches, such as workspace
+    // indexing, link checks and style jobs, created on first use. Batches
+    // queue behind one another, so keeping them off shared() keeps them from
+    // holding up the lexer.
+    static ThreadPool& background();
+
+    static unsigned defaultThreads();
+
+private:
+    void workerLoop();
+    void runTasks(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers_;
+    std::mutex submitMutex_;            // one batch at a time
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::vector<std::function<void()>>* batch_ = nullptr;
+    size_t next_ = 0;                   // next task to hand out
+    size_t finished_ = 0;
+    unsigned generation_ = 0;           // bumped for every batch
+    bool stopping_ = false;
+};
@@ -0,0 +1,481 @@
+#include "WorkspaceIndex.h"
+#include "MarkdownSummary.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Changed files are read and parsed this many at a time. Cancelling is
+// checked between rounds, so it takes effect without waiting for a cold
+// build of a large workspace, and each batch on the background pool is
+// short enough not to hold up the work queued behind it for long.
+const size_t parseRoundFiles = 256;
+
+uint64_t contentHash(std::string_view text)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (char c : text) h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    return h;
+}
+
+int64_t fileTicks(fs::file_time_type time)
+{
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+bool readFile(const fs::path& path, std::string& text)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    if (size < 0) return false;
+    in.seekg(0, std::ios::beg);
+    text.resize(static_cast<size_t>(size));
+    if (size > 0) in.read(&text[0], size);
+    return static_cast<bool>(in);
+}
+
+// A file of a build and where its entry comes from.
+enum ItemAction
+{
+    ITEM_COPY,          // the previous entry as it is
+    ITEM_TOUCH,         // the previous entry with a new time and size
+    ITEM_READ,          // read, and parsed unless the hash matches
+    ITEM_PARSE,
+    ITEM_DROP           // could not be read
+};
+
+struct BuildItem
+{
+    std::string path;
+    const WorkspaceSource* source = nullptr;    // nullptr for one kept from the last index
+    int previous = -1;
+    ItemAction action = ITEM_READ;
+    uint64_t hash = 0;
+    size_t summary = 0;
+};
+
+// Collects entries and strings in the order they are written.
+class IndexWriter
+{
+public:
+    IndexString add(std::string_view text)
+    {
+        const IndexString s = { static_cast<uint32_t>(strings_.size()), static_cast<uint32_t>(text.size()) };
+        strings_.append(text);
+        return s;
+    }
+
+    void addFile(const BuildItem& item, const MarkdownSummary& summary)
+    {
+        IndexFile& file = startFile(item);
+        file.words = summary.words;
+        for (const SummaryHeading& heading : summary.headings) {
+            headings_.push_back({ static_cast<uint32_t>(heading.line), static_cast<uint32_t>(heading.level),
+                                  add(heading.text), add(heading.anchor) });
+        }
+        for (const SummaryLink& link : summary.links) {
+            links_.push_back({ static_cast<uint32_t>(link.line), static_cast<uint32_t>(link.column),
+                               static_cast<uint32_t>(link.kind), 0, add(link.target) });
+        }
+        for (const SummaryReference& reference : summary.references) {
+            references_.push_back({ static_cast<uint32_t>(reference.line), 0, add(reference.label), add(reference.target) });
+        }
+        endFile();
+    }
+
+    void copyFile(const BuildItem& item, const WorkspaceIndex& from)
+    {
+        IndexFile& file = startFile(item);
+        const IndexFile& old = from.file(item.previous);
+        file.words = old.words;
+        if (!item.source) {
+            file.modified = old.modified;
+            file.size = old.size;
+        }
+        if (item.action == ITEM_COPY) file.hash = old.hash;
+        for (const IndexHeading& heading : from.headings(item.previous)) {
+            headings_.push_back({ heading.line, heading.level, add(from.string(heading.text)), add(from.string(heading.anchor)) });
+        }
+        for (const IndexLink& link : from.links(item.previous)) {
+            links_.push_back({ link.line, link.column, link.kind, 0, add(from.string(link.target)) });
+        }
+        for (const IndexReference& reference : from.references(item.previous)) {
+            references_.push_back({ reference.line, 0, add(from.string(reference.label)), add(from.string(reference.target)) });
+        }
+        endFile();
+    }
+
+    // The sections laid out after the header, in 8-byte words.
+    void finish(std::string_view root, std::vector<uint64_t>& out)
+    {
+        IndexHeader header = {};
+        memcpy(header.magic, WORKSPACE_INDEX_MAGIC, sizeof(header.magic));
+        header.version = WORKSPACE_INDEX_VERSION;
+        header.root = add(root);
+        header.fileCount = static_cast<uint32_t>(files_.size());
+        header.headingCount = static_cast<uint32_t>(headings_.size());
+        header.linkCount = static_cast<uint32_t>(links_.size());
+        header.referenceCount = static_cast<uint32_t>(references_.size());
+        header.stringBytes = static_cast<uint32_t>(strings_.size());
+        header.filesOffset = sizeof(IndexHeader);
+        header.headingsOffset = header.filesOffset + files_.size() * sizeof(IndexFile);
+        header.linksOffset = header.headingsOffset + headings_.size() * sizeof(IndexHeading);
+        header.referencesOffset = header.linksOffset + links_.size() * sizeof(IndexLink);
+        header.stringsOffset = header.referencesOffset + references_.size() * sizeof(IndexReference);
+
+        out.assign((header.stringsOffset + strings_.size() + 7) / 8, 0);
+        char* base = reinterpret_cast<char*>(out.data());
+        memcpy(base, &header, sizeof(header));
+        copySection(base + header.filesOffset, files_);
+        copySection(base + header.headingsOffset, headings_);
+        copySection(base + header.linksOffset, links_);
+        copySection(base + header.referencesOffset, references_);
+        if (!strings_.empty()) memcpy(base + header.stringsOffset, strings_.data(), strings_.size());
+    }
+
+private:
+    IndexFile& startFile(const BuildItem& item)
+    {
+        files_.emplace_back();
+        IndexFile& file = files_.back();
+        file = IndexFile();
+        file.path = add(item.path);
+        file.firstHeading = static_cast<uint32_t>(headings_.size());
+        file.firstLink = static_cast<uint32_t>(links_.size());
+        file.firstReference = static_cast<uint32_t>(references_.size());
+        if (item.source) {
+            file.modified = item.source->modified;
+            file.size = item.source->size;
+        }
+        file.hash = item.hash;
+        return file;
+    }
+
+    void endFile()
+    {
+        IndexFile& file = files_.back();
+        file.headingCount = static_cast<uint32_t>(headings_.size()) - file.firstHeading;
+        file.linkCount = static_cast<uint32_t>(links_.size()) - file.firstLink;
+        file.referenceCount = static_cast<uint32_t>(references_.size()) - file.firstReference;
+    }
+
+    template <typename T>
+    static void copySection(char* to, const std::vector<T>& entries)
+    {
+        if (!entries.empty()) memcpy(to, entries.data(), entries.size() * sizeof(T));
+    }
+
+    std::vector<IndexFile> files_;
+    std::vector<IndexHeading> headings_;
+    std::vector<IndexLink> links_;
+    std::vector<IndexReference> references_;
+    std::string strings_;
+};
+
+bool validString(IndexString s, uint32_t stringBytes)
+{
+    return static_cast<uint64_t>(s.offset) + s.length <= stringBytes;
+}
+
+bool validSection(uint64_t offset, uint64_t count, size_t entrySize, size_t size)
+{
+    return offset % 8 == 0 && offset <= size && count * entrySize <= size - offset;
+}
+
+bool validRange(uint32_t first, uint32_t count, uint32_t total)
+{
+    return static_cast<uint64_t>(first) + count <= total;
+}
+
+}
+
+bool isMarkdownPath(const fs::path& path)
+{
+    std::string extension = path.extension().u8string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; });
+    return extension == ".md" || extension == ".mkd" || extension == ".markdown";
+}
+
+std::vector<WorkspaceSource> findMarkdownFiles(const fs::path& root, const CancelToken& cancel)
+{
+    std::vector<WorkspaceSource> sources;
+    std::error_code error;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error);
+    for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+        if (cancel.cancelled()) break;
+        const fs::directory_entry& entry = *it;
+        std::error_code entryError;
+        if (entry.is_directory(entryError)) {
+            const std::string name = entry.path().filename().u8string();
+            if (!name.empty() && name[0] == '.') it.disable_recursion_pending();
+            continue;
+        }
+        if (!isMarkdownPath(entry.path()) || !entry.is_regular_file(entryError)) continue;
+        WorkspaceSource source;
+        source.path = entry.path();
+        source.modified = fileTicks(entry.last_write_time(entryError));
+        source.size = entry.file_size(entryError);
+        if (!entryError) sources.push_back(std::move(source));
+    }
+    return sources;
+}
+
+bool statSource(const fs::path& path, WorkspaceSource& source)
+{
+    std::error_code error;
+    const fs::file_time_type modified = fs::last_write_time(path, error);
+    if (error) return false;
+    const uintmax_t size = fs::file_size(path, error);
+    if (error) return false;
+    source.path = path;
+    source.modified = fileTicks(modified);
+    source.size = size;
+    return true;
+}
+
+std::string WorkspaceIndex::relativePath(const fs::path& path, const fs::path& root)
+{
+    const fs::path relative = path.lexically_normal().lexically_relative(root.lexically_normal());
+    return (relative.empty() ? path.lexically_normal() : relative).generic_u8string();
+}
+
+std::shared_ptr<const WorkspaceIndex> WorkspaceIndex::open(const fs::path& path, const fs::path& root)
+{
+    std::shared_ptr<WorkspaceIndex> index(new WorkspaceIndex());
+    if (!index->mapped_.open(path)) return nullptr;
+    const std::string_view bytes = index->mapped_.view();
+    if (!index->attach(bytes.data(), bytes.size())) return nullptr;
+    if (index->root() != root.lexically_normal().generic_u8string()) return nullptr;
+    return index;
+}
+
+std::shared_ptr<const WorkspaceIndex> WorkspaceIndex::build(const std::shared_ptr<const WorkspaceIndex>& previous,
+                                                            const fs::path& root,
+                                                            const std::vector<WorkspaceSource>& sources, bool complete,
+                                                            ThreadPool& pool, const CancelToken& cancel,
+                                                            WorkspaceBuild& report)
+{
+    report = WorkspaceBuild();
+
+    // The files, sorted by path as the index keeps them. A path given twice
+    // is looked at once.
+    std::vector<BuildItem> items;
+    items.reserve(sources.size());
+    for (const WorkspaceSource& source : sources) {
+        BuildItem item;
+        item.path = relativePath(source.path, root);
+        item.source = &source;
+        items.push_back(std::move(item));
+    }
+    auto byPath = [](const BuildItem& a, const BuildItem& b) { return a.path < b.path; };
+    std::stable_sort(items.begin(), items.end(), byPath);
+    items.erase(std::unique(items.begin(), items.end(),
+                            [](const BuildItem& a, const BuildItem& b) { return a.path == b.path; }),
+                items.end());
+
+    const size_t previousFiles = previous ? previous->fileCount() : 0;
+    if (previous) {
+        for (BuildItem& item : items) {
+            item.previous = previous->findFile(item.path);
+            if (item.previous < 0) continue;
+            const IndexFile& old = previous->file(item.previous);
+            if (old.modified == item.source->modified && old.size == item.source->size) {
+                item.action = ITEM_COPY;
+                report.unchanged++;
+            }
+        }
+        if (!complete) {
+            // The files not given are kept as they are.
+            const size_t given = items.size();
+            std::vector<bool> seen(previousFiles);
+            for (size_t i = 0; i < given; i++) {
+                if (items[i].previous >= 0) seen[items[i].previous] = true;
+            }
+            for (size_t i = 0; i < previousFiles; i++) {
+                if (seen[i]) continue;
+                BuildItem item;
+                item.path.assign(previous->path(i));
+                item.previous = static_cast<int>(i);
+                item.action = ITEM_COPY;
+                items.push_back(std::move(item));
+            }
+            std::inplace_merge(items.begin(), items.begin() + given, items.end(), byPath);
+        }
+    }
+
+    // Read the files that changed, or may have, and parse the ones whose
+    // content did.
+    std::vector<BuildItem*> pending;
+    for (BuildItem& item : items) {
+        if (item.action == ITEM_READ) pending.push_back(&item);
+    }
+    std::vector<MarkdownSummary> summaries(pending.size());
+    for (size_t round = 0; round < pending.size(); round += parseRoundFiles) {
+        if (cancel.cancelled()) return nullptr;
+        const size_t roundEnd = std::min(pending.size(), round + parseRoundFiles);
+        std::atomic<size_t> next(round);
+        auto work = [&]() {
+            static thread_local std::string text;
+            for (size_t i = next++; i < roundEnd; i = next++) {
+                BuildItem& item = *pending[i];
+                item.summary = i;
+                if (!readFile(item.source->path, text)) {
+                    item.action = ITEM_DROP;
+                    continue;
+                }
+                item.hash = contentHash(text);
+                if (item.previous >= 0 && previous->file(item.previous).hash == item.hash) {
+                    item.action = ITEM_TOUCH;
+                    continue;
+                }
+                summarizeMarkdown(text, summaries[i]);
+                item.action = ITEM_PARSE;
+            }
+        };
+        std::vector<std::function<void()>> tasks(std::min<size_t>(pool.concurrency(), roundEnd - round), work);
+        pool.run(tasks);
+    }
+    if (cancel.cancelled()) return nullptr;
+
+    size_t kept = 0;
+    for (const BuildItem& item : items) {
+        if (item.action == ITEM_TOUCH) report.touched++;
+        if (item.action == ITEM_PARSE) report.parsed++;
+        if (item.action == ITEM_DROP) report.unreadable++;
+        if (item.previous >= 0 && item.action != ITEM_DROP) kept++;
+    }
+    report.removed = previousFiles - kept;
+    if (previous && !report.changed()) return previous;
+
+    IndexWriter writer;
+    for (const BuildItem& item : items) {
+        if (item.action == ITEM_PARSE) {
+            writer.addFile(item, summaries[item.summary]);
+        } else if (item.action != ITEM_DROP) {
+            writer.copyFile(item, *previous);
+        }
+    }
+    std::shared_ptr<WorkspaceIndex> index(new WorkspaceIndex());
+    writer.finish(root.lexically_normal().generic_u8string(), index->memory_);
+    index->attach(reinterpret_cast<const char*>(index->memory_.data()), index->memory_.size() * 8);
+    return index;
+}
+
+bool WorkspaceIndex::save(const fs::path& path) const
+{
+    std::error_code error;
+    fs::create_directories(path.parent_path(), error);
+    fs::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(data_, static_cast<std::streamsize>(size_));
+        if (!out) return false;
+    }
+
+    // Windows will not replace a file that is mapped, as the index being
+    // replaced usually is, but it will rename it out of the way.
+    fs::rename(temporary, path, error);
+    if (error) {
+        fs::path aside = path;
+        aside += ".old";
+        fs::remove(aside, error);
+        fs::rename(path, aside, error);
+        fs::rename(temporary, path, error);
+        if (error) return false;
+        fs::remove(aside, error);
+    }
+    return true;
+}
+
+int WorkspaceIndex::findFile(std::string_view path) const
+{
+    size_t low = 0;
+    size_t high = fileCount();
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        const int order = this->path(middle).compare(path);
+        if (order == 0) return static_cast<int>(middle);
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return -1;
+}
+
+IndexRange<IndexHeading> WorkspaceIndex::headings(size_t file) const
+{
+    const IndexFile& f = files_[file];
+    return { headings_ + f.firstHeading, headings_ + f.firstHeading + f.headingCount };
+}
+
+IndexRange<IndexLink> WorkspaceIndex::links(size_t file) const
+{
+    const IndexFile& f = files_[file];
+    return { links_ + f.firstLink, links_ + f.firstLink + f.linkCount };
+}
+
+IndexRange<IndexReference> WorkspaceIndex::references(size_t file) const
+{
+    const IndexFile& f = files_[file];
+    return { references_ + f.firstReference, references_ + f.firstReference + f.referenceCount };
+}
+
+// Check everything a lookup could follow, so a damaged or truncated file is
+// turned away here rather than read out of bounds later.
+bool WorkspaceIndex::attach(const char* data, size_t size)
+{
+    if (size < sizeof(IndexHeader)) return false;
+    const IndexHeader* header = reinterpret_cast<const IndexHeader*>(data);
+    if (memcmp(header->magic, WORKSPACE_INDEX_MAGIC, sizeof(header->magic)) != 0) return false;
+    if (header->version != WORKSPACE_INDEX_VERSION) return false;
+    if (!validSection(header->filesOffset, header->fileCount, sizeof(IndexFile), size) ||
+        !validSection(header->headingsOffset, header->headingCount, sizeof(IndexHeading), size) ||
+        !validSection(header->linksOffset, header->linkCount, sizeof(IndexLink), size) ||
+        !validSection(header->referencesOffset, header->referenceCount, sizeof(IndexReference), size) ||
+        !validSection(header->stringsOffset, header->stringBytes, 1, size) ||
+        !validString(header->root, header->stringBytes)) {
+        return false;
+    }
+
+    header_ = header;
+    data_ = data;
+    size_ = size;
+    files_ = reinterpret_cast<const IndexFile*>(data + header->filesOffset);
+    headings_ = reinterpret_cast<const IndexHeading*>(data + header->headingsOffset);
+    links_ = reinterpret_cast<const IndexLink*>(data + header->linksOffset);
+    references_ = reinterpret_cast<const IndexReference*>(data + header->referencesOffset);
+    strings_ = data + header->stringsOffset;
+
+    const uint32_t stringBytes = header->stringBytes;
+    for (size_t i = 0; i < header->fileCount; i++) {
+        const IndexFile& file = files_[i];
+        if (!validString(file.path, stringBytes) || (i > 0 && path(i - 1) >= path(i)) ||
+            !validRange(file.firstHeading, file.headingCount, header->headingCount) ||
+            !validRange(file.firstLink, file.linkCount, header->linkCount) ||
+            !validRange(file.firstReference, file.referenceCount, header->referenceCount)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < header->headingCount; i++) {
+        if (!validString(headings_[i].text, stringBytes) || !validString(headings_[i].anchor, stringBytes)) return false;
+    }
+    for (size_t i = 0; i < header->linkCount; i++) {
+        if (!validString(links_[i].target, stringBytes)) return false;
+    }
+    for (size_t i = 0; i < header->referenceCount; i++) {
+        if (!validString(references_[i].label, stringBytes) || !validString(references_[i].target, stringBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
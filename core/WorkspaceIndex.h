@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "TaskScheduler.h"
+#include "ThreadPool.h"
+
+// On-disk format of the workspace index, the same on every platform.
+// Integers are little-endian and every section starts on an 8-byte
+// boundary:
+//
+//   IndexHeader
+//   IndexFile[fileCount]              sorted by path
+//   IndexHeading[headingCount]        each file's entries together, in line order
+//   IndexLink[linkCount]
+//   IndexReference[referenceCount]
+//   strings                           UTF-8, referenced by offset and length
+//
+// A file with another magic or version is ignored and rebuilt.
+#define WORKSPACE_INDEX_MAGIC "BMDINDEX"
+#define WORKSPACE_INDEX_VERSION 1
+
+struct IndexString
+{
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct IndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t fileCount;
+    uint32_t headingCount;
+    uint32_t linkCount;
+    uint32_t referenceCount;
+    uint32_t stringBytes;
+    IndexString root;           // the directory paths are relative to
+    uint64_t filesOffset;
+    uint64_t headingsOffset;
+    uint64_t linksOffset;
+    uint64_t referencesOffset;
+    uint64_t stringsOffset;
+};
+
+struct IndexFile
+{
+    IndexString path;           // relative to the root, / separated
+    uint32_t words;
+    uint32_t firstHeading;
+    uint32_t headingCount;
+    uint32_t firstLink;
+    uint32_t linkCount;
+    uint32_t firstReference;
+    uint32_t referenceCount;
+    uint32_t reserved;
+    int64_t modified;           // last write time, in the file system's own ticks
+    uint64_t size;
+    uint64_t hash;              // FNV-1a of the content
+};
+
+struct IndexHeading
+{
+    uint32_t line;
+    uint32_t level;
+    IndexString text;
+    IndexString anchor;
+};
+
+struct IndexLink
+{
+    uint32_t line;
+    uint32_t column;
+    uint32_t kind;              // LinkKind
+    uint32_t reserved;
+    IndexString target;
+};
+
+struct IndexReference
+{
+    uint32_t line;
+    uint32_t reserved;
+    IndexString label;
+    IndexString target;
+};
+
+static_assert(sizeof(IndexHeader) == 80 && sizeof(IndexFile) == 64 && sizeof(IndexHeading) == 24 &&
+              sizeof(IndexLink) == 24 && sizeof(IndexReference) == 24, "the on-disk layout is fixed");
+
+// A file to index, with the size and time the index compares.
+struct WorkspaceSource
+{
+    std::filesystem::path path;
+    int64_t modified = 0;
+    uint64_t size = 0;
+};
+
+// Whether path ends in .md, .mkd or .markdown, in any case.
+bool isMarkdownPath(const std::filesystem::path& path);
+
+// Every Markdown file under root, skipping hidden directories. Times and
+// sizes come with the directory listing where the platform has them there.
+std::vector<WorkspaceSource> findMarkdownFiles(const std::filesystem::path& root, const CancelToken& cancel);
+
+// The time and size of one file; false when it cannot be read.
+bool statSource(const std::filesystem::path& path, WorkspaceSource& source);
+
+// What a build did with the files it was given.
+struct WorkspaceBuild
+{
+    size_t unchanged = 0;       // same time and size: the entry was copied
+    size_t touched = 0;         // new time but the same hash: the entry was copied
+    size_t parsed = 0;          // new or changed
+    size_t removed = 0;
+    size_t unreadable = 0;
+
+    bool changed() const { return touched || parsed || removed; }
+};
+
+template <typename T>
+struct IndexRange
+{
+    const T* first;
+    const T* last;
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    const T& operator[](size_t i) const { return first[i]; }
+};
+
+// The headings, links, reference definitions and word counts of every
+// Markdown file in a workspace. An index is never changed: a build makes
+// a new one from the last, and only parses the files whose time or size
+// differ and whose content hash then differs too. An index opened from
+// disk is mapped rather than read, so a cold start costs a stat per file.
+class WorkspaceIndex
+{
+public:
+    // Map the index at path. nullptr when there is none, or it is damaged,
+    // of another version or for another root.
+    static std::shared_ptr<const WorkspaceIndex> open(const std::filesystem::path& path,
+                                                      const std::filesystem::path& root);
+
+    // An index of sources, taking what it can from previous. With complete
+    // set, sources is every file and the others are dropped; otherwise only
+    // sources are looked at and the rest are kept as they are. Changed files
+    // are read and parsed on pool. Returns previous itself when nothing
+    // changed, and nullptr when cancelled.
+    static std::shared_ptr<const WorkspaceIndex> build(const std::shared_ptr<const WorkspaceIndex>& previous,
+                                                       const std::filesystem::path& root,
+                                                       const std::vector<WorkspaceSource>& sources, bool complete,
+                                                       ThreadPool& pool, const CancelToken& cancel,
+                                                       WorkspaceBuild& report);
+
+    // Write the index to path through a temporary file, so a reader never
+    // sees half of it.
+    bool save(const std::filesystem::path& path) const;
+
+    std::string_view root() const { return string(header_->root); }
+    size_t fileCount() const { return header_->fileCount; }
+    const IndexFile& file(size_t i) const { return files_[i]; }
+    std::string_view path(size_t i) const { return string(files_[i].path); }
+
+    // The file with a path relative to the root, or -1.
+    int findFile(std::string_view path) const;
+
+    IndexRange<IndexHeading> headings(size_t file) const;
+    IndexRange<IndexLink> links(size_t file) const;
+    IndexRange<IndexReference> references(size_t file) const;
+
+    std::string_view string(IndexString s) const { return std::string_view(strings_ + s.offset, s.length); }
+
+    // The bytes of the index, as save() writes them.
+    std::string_view bytes() const { return std::string_view(data_, size_); }
+
+    // The path of a file relative to root, as the index keeps it.
+    static std::string relativePath(const std::filesystem::path& path, const std::filesystem::path& root);
+
+private:
+    WorkspaceIndex() = default;
+    bool attach(const char* data, size_t size);
+
+    MappedFile mapped_;
+    std::vector<uint64_t> memory_;      // a built index, 8-byte aligned like a mapped one
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const IndexHeader* header_ = nullptr;
+    const IndexFile* files_ = nullptr;
+    const IndexHeading* headings_ = nullptr;
+    const IndexLink* links_ = nullptr;
+    const IndexReference* references_ = nullptr;
+    const char* strings_ = nullptr;
+};
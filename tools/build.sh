@@ -0,0 +1,39 @@
+#!/bin/sh
+# Builds the command-line tools into bin/ with g++ or clang++:
+#
+#   mdlinkcheck     the link checker
+#   keywordtables   multipliers for the keyword tables of core/CodeLexer.cpp
+#   keywordbench    the keyword tables against std::unordered_set, on a
+#                   corpus from keywordcorpus.sh
+#   lineindexbench  LineIndex lookups against asking the view
+#   spscstress      stress test of SpscQueue and StyleWorker (run by check.sh)
+#   spscbench       SpscQueue against a locked deque
+#   themecheck      checks of applyTheme() on a fake view (run by check.sh)
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-std=c++17 -O2 -pthread"}
+mkdir -p bin
+
+LEXER="../core/LineClassifier.cpp ../core/MarkdownLexer.cpp ../core/CodeLexer.cpp ../core/Arena.cpp
+ ../core/BlockTree.cpp ../core/DocumentView.cpp ../core/DocumentBlocks.cpp ../core/HeadingIndex.cpp"
+
+$CXX $CXXFLAGS -o bin/mdlinkcheck mdlinkcheck.cpp $LEXER \
+ ../core/ThreadPool.cpp \
+ ../core/TaskScheduler.cpp \
+ ../core/MarkdownSummary.cpp \
+ ../core/MappedFile.cpp \
+ ../core/WorkspaceIndex.cpp \
+ ../core/LinkChecker.cpp
+$CXX $CXXFLAGS -o bin/keywordtables keywordtables.cpp
+$CXX $CXXFLAGS -o bin/keywordbench keywordbench.cpp $LEXER
+$CXX $CXXFLAGS -o bin/lineindexbench lineindexbench.cpp ../core/LineIndex.cpp ../core/LineClassifier.cpp \
+ ../core/DocumentView.cpp
+$CXX $CXXFLAGS -o bin/spscstress spscstress.cpp $LEXER \
+ ../core/ThreadPool.cpp \
+ ../core/TaskScheduler.cpp \
+ ../core/ParallelLexer.cpp \
+ ../core/StyleWorker.cpp
+$CXX $CXXFLAGS -o bin/spscbench spscbench.cpp
+$CXX $CXXFLAGS -o bin/themecheck themecheck.cpp ../core/StylePalette.cpp
+echo "Built bin/mdlinkcheck bin/keywordtables bin/keywordbench bin/lineindexbench bin/spscstress bin/spscbench bin/themecheck"
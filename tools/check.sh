@@ -0,0 +1,9 @@
+#!/bin/sh
+# Builds the tools and runs the checks among them. Exits nonzero when one
+# fails.
+set -e
+cd "$(dirname "$0")"
+./build.sh
+bin/spscstress
+bin/themecheck
+echo "All checks passed"
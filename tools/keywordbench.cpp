@@ -0,0 +1,184 @@
+// Keyword lookups in the fenced code blocks of a Markdown file, through the
+// perfect hash tables the code lexer uses and through the containers they
+// replaced: std::unordered_set and binary search of a sorted array. Each
+// block is looked up in the set of its info string's language; make a
+// corpus with keywordcorpus.sh. Then times lexing the whole file.
+//
+//   keywordbench FILE [ROUNDS]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "../core/CodeKeywords.h"
+#include "../core/KeywordTable.h"
+#include "../core/MarkdownLexer.h"
+
+namespace {
+
+// One keyword set in each of the three forms. All three lookups are virtual
+// calls, so each pays the same for finding the block's set.
+class Lookups
+{
+public:
+    virtual ~Lookups() = default;
+    virtual bool inTable(std::string_view word) const = 0;
+    virtual bool inSet(std::string_view word) const { return set_.count(word) != 0; }
+    virtual bool inSorted(std::string_view word) const
+    {
+        return std::binary_search(sorted_.begin(), sorted_.end(), word);
+    }
+
+protected:
+    template <size_t N>
+    explicit Lookups(const std::string_view (&words)[N]) : set_(words, words + N), sorted_(words, words + N)
+    {
+        std::sort(sorted_.begin(), sorted_.end());
+    }
+
+private:
+    std::unordered_set<std::string_view> set_;
+    std::vector<std::string_view> sorted_;
+};
+
+template <size_t N>
+class KeywordLookups : public Lookups
+{
+public:
+    explicit KeywordLookups(const std::string_view (&words)[N])
+        : Lookups(words), table_(words, KeywordTable<N>::findMultiplier(words)) {}
+
+    bool inTable(std::string_view word) const override { return table_.contains(word); }
+
+private:
+    KeywordTable<N> table_;
+};
+
+const KeywordLookups cLookups(cKeywords);
+const KeywordLookups jsLookups(jsKeywords);
+const KeywordLookups pythonLookups(pythonKeywords);
+const KeywordLookups jsonLookups(jsonKeywords);
+const KeywordLookups yamlLookups(yamlKeywords);
+const KeywordLookups shellLookups(shellKeywords);
+const KeywordLookups sqlLookups(sqlKeywords);
+
+const Lookups* lookupsFor(std::string_view language)
+{
+    static const struct { std::string_view name; const Lookups* lookups; } languages[] = {
+        { "c", &cLookups }, { "h", &cLookups }, { "cpp", &cLookups }, { "c++", &cLookups },
+        { "js", &jsLookups }, { "javascript", &jsLookups }, { "ts", &jsLookups },
+        { "py", &pythonLookups }, { "python", &pythonLookups },
+        { "json", &jsonLookups }, { "yaml", &yamlLookups }, { "yml", &yamlLookups },
+        { "sh", &shellLookups }, { "bash", &shellLookups }, { "sql", &sqlLookups },
+    };
+    for (const auto& known : languages) {
+        if (known.name == language) return known.lookups;
+    }
+    return nullptr;
+}
+
+struct Word
+{
+    const Lookups* lookups;
+    std::string_view text;
+};
+
+bool isWordStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isWordChar(char c)
+{
+    return isWordStart(c) || (c >= '0' && c <= '9');
+}
+
+// The identifiers of the fenced blocks in a known language, each with its
+// block's keyword set.
+std::vector<Word> codeWords(std::string_view text)
+{
+    std::vector<Word> words;
+    const Lookups* lookups = nullptr;
+    bool inFence = false;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        const std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+        if (line.compare(0, 3, "```") == 0) {
+            inFence = !inFence;
+            lookups = inFence ? lookupsFor(line.substr(3, line.find_first_of(" \r", 3) - 3)) : nullptr;
+            continue;
+        }
+        if (!lookups) continue;
+        for (size_t i = 0; i < line.size();) {
+            if (!isWordStart(line[i])) {
+                // Skip the rest of a number or other word.
+                while (i < line.size() && isWordChar(line[i])) i++;
+                if (i < line.size()) i++;
+                continue;
+            }
+            size_t j = i + 1;
+            while (j < line.size() && isWordChar(line[j])) j++;
+            words.push_back({ lookups, line.substr(i, j - i) });
+            i = j;
+        }
+    }
+    return words;
+}
+
+template <typename Lookup>
+void timeLookups(const char* name, const std::vector<Word>& words, int rounds, Lookup lookup)
+{
+    size_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const Word& word : words) hits += lookup(*word.lookups, word.text);
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-16s %7.1f M lookups/s, %zu keywords\n", name, words.size() * rounds / s / 1e6, hits / rounds);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: keywordbench FILE [ROUNDS]\n");
+        return 2;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "keywordbench: cannot read %s\n", argv[1]);
+        return 2;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+    const int rounds = (argc > 2) ? atoi(argv[2]) : 20;
+
+    const std::vector<Word> words = codeWords(text);
+    printf("%zu bytes, %zu identifiers in code blocks\n", text.size(), words.size());
+    timeLookups("KeywordTable", words, rounds, [](const Lookups& l, std::string_view w) { return l.inTable(w); });
+    timeLookups("unordered_set", words, rounds, [](const Lookups& l, std::string_view w) { return l.inSet(w); });
+    timeLookups("binary search", words, rounds, [](const Lookups& l, std::string_view w) { return l.inSorted(w); });
+
+    LexOutput out;
+    double best = 0;
+    for (int round = 0; round < rounds; round++) {
+        const auto start = std::chrono::steady_clock::now();
+        lexMarkdown(text, 0, true, out);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (round == 0 || ms < best) best = ms;
+    }
+    printf("lexMarkdown      %7.1f ms, best of %d\n", best, rounds);
+    return 0;
+}
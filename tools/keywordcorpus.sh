@@ -0,0 +1,29 @@
+#!/bin/sh
+# Writes a fence-heavy Markdown corpus for keywordbench to standard output:
+# each source file found under the directories given becomes a fenced code
+# block, tagged with the language of its extension. Other files are
+# skipped.
+#
+#   keywordcorpus.sh DIR... > corpus.md
+#
+# For example, this repo's sources and Python's standard library:
+#
+#   keywordcorpus.sh ../core ../plugin /usr/lib/python3* > corpus.md
+set -e
+find "$@" -type f \( -name '*.c' -o -name '*.cpp' -o -name '*.h' -o -name '*.py' -o -name '*.js' \
+ -o -name '*.sh' -o -name '*.sql' -o -name '*.json' -o -name '*.yaml' -o -name '*.yml' \) | sort |
+while read -r file; do
+    case "$file" in
+        *.py) language=python ;;
+        *.js) language=js ;;
+        *.sh) language=sh ;;
+        *.sql) language=sql ;;
+        *.json) language=json ;;
+        *.yaml|*.yml) language=yaml ;;
+        *) language=cpp ;;
+    esac
+    printf '## %s\n\n```%s\n' "$file" "$language"
+    # A fence inside the file would end the block early.
+    sed 's/^\( *\)```/\1` ``/' "$file"
+    printf '\n```\n\n'
+done
@@ -0,0 +1,34 @@
+// Prints a multiplier for each keyword set in core/CodeKeywords.h, to paste
+// into the KeywordTable definitions in core/CodeLexer.cpp after a set
+// changes. Compilers cannot afford the search as a constant expression.
+//
+//   keywordtables
+
+#include <cstdio>
+
+#include "../core/CodeKeywords.h"
+#include "../core/KeywordTable.h"
+
+namespace {
+
+template <size_t N>
+void print(const char* name, const std::string_view (&words)[N])
+{
+    printf("%-16s %2zu words, %3zu slots: 0x%016llxull\n", name, N, KeywordTable<N>::slotCount,
+           static_cast<unsigned long long>(KeywordTable<N>::findMultiplier(words)));
+}
+
+}
+
+int main()
+{
+    print("cKeywords", cKeywords);
+    print("jsKeywords", jsKeywords);
+    print("pythonKeywords", pythonKeywords);
+    print("jsonKeywords", jsonKeywords);
+    print("yamlKeywords", yamlKeywords);
+    print("shellKeywords", shellKeywords);
+    print("sqlKeywords", sqlKeywords);
+    print("languageNames", languageNames);
+    return 0;
+}
@@ -0,0 +1,230 @@
+// What LineIndex costs and saves: line and position lookups from a snapshot
+// against the same lookups asked of a view with SCI_LINEFROMPOSITION and
+// SCI_POSITIONFROMLINE.
+//
+//   lineindexbench FILE [LOOKUPS] [EDITS]
+//
+// There is no Scintilla on Linux, so the view is a fake that answers from a
+// flat array of line starts, which is about what Scintilla's own partition
+// costs. It is asked two ways: through ScintillaCall on its own thread, the
+// cheapest a message can be, and from a worker thread that has to wait for
+// the view's thread to answer, as SendMessage from a worker does. The
+// second is what the index replaces. Then times indexing the file and
+// keeping the index current across random edits.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/LineIndex.h"
+
+namespace {
+
+// Answers line queries about a fixed text.
+class FakeView : public ScintillaCall
+{
+public:
+    explicit FakeView(const std::string& text) : length_(static_cast<Sci_Position>(text.size()))
+    {
+        starts_.push_back(0);
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\n' || (text[i] == '\r' && (i + 1 == text.size() || text[i + 1] != '\n'))) {
+                starts_.push_back(static_cast<Sci_Position>(i + 1));
+            }
+        }
+    }
+
+    sptr_t call(unsigned int message, uptr_t wParam, sptr_t) override
+    {
+        const Sci_Position count = static_cast<Sci_Position>(starts_.size());
+        switch (message) {
+        case SCI_GETLINECOUNT:
+            return count;
+        case SCI_POSITIONFROMLINE:
+            return (static_cast<Sci_Position>(wParam) < count) ? starts_[wParam] : length_;
+        case SCI_LINEFROMPOSITION:
+            return std::upper_bound(starts_.begin(), starts_.end(), static_cast<Sci_Position>(wParam)) -
+                   starts_.begin() - 1;
+        }
+        return 0;
+    }
+
+private:
+    std::vector<Sci_Position> starts_;
+    Sci_Position length_;
+};
+
+// Hands calls from one other thread to the thread running serve() and
+// waits for the answer, the way SendMessage does across threads.
+class MarshalledCall : public ScintillaCall
+{
+public:
+    explicit MarshalledCall(ScintillaCall& view) : view_(view) {}
+
+    sptr_t call(unsigned int message, uptr_t wParam, sptr_t lParam) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        message_ = message;
+        wParam_ = wParam;
+        lParam_ = lParam;
+        pending_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return !pending_; });
+        return reply_;
+    }
+
+    // Answer calls until stop().
+    void serve()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return pending_ || stopping_; });
+            if (!pending_) return;
+            reply_ = view_.call(message_, wParam_, lParam_);
+            pending_ = false;
+            cv_.notify_all();
+        }
+    }
+
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    ScintillaCall& view_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_ = false;
+    bool stopping_ = false;
+    unsigned int message_ = 0;
+    uptr_t wParam_ = 0;
+    sptr_t lParam_ = 0;
+    sptr_t reply_ = 0;
+};
+
+double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Each position's line, then that line's start, summed so neither way can
+// be skipped.
+template <typename LineFrom, typename StartOf>
+Sci_Position lookUp(const std::vector<Sci_Position>& positions, LineFrom lineFrom, StartOf startOf)
+{
+    Sci_Position sum = 0;
+    for (Sci_Position position : positions) sum += startOf(lineFrom(position));
+    return sum;
+}
+
+void report(const char* name, size_t lookups, double ms, Sci_Position sum)
+{
+    printf("%-22s %9.1f ms %8.3f us/lookup  (%lld)\n", name, ms, ms * 1000 / lookups, static_cast<long long>(sum));
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: lineindexbench FILE [LOOKUPS] [EDITS]\n");
+        return 2;
+    }
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "lineindexbench: cannot read %s\n", argv[1]);
+        return 2;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    const size_t lookups = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 100000;
+    const size_t edits = (argc > 3) ? strtoull(argv[3], nullptr, 10) : 1000;
+
+    std::mt19937 random(1);
+    std::vector<Sci_Position> positions(lookups);
+    for (Sci_Position& position : positions) position = random() % (text.size() + 1);
+
+    LineIndex index;
+    auto start = std::chrono::steady_clock::now();
+    {
+        TextDocumentView document(text);
+        index.reset(document);
+    }
+    const double resetMs = since(start);
+    const std::shared_ptr<const LineSnapshot> snapshot = index.snapshot();
+    printf("%zu bytes, %lld lines, %zu lookups of a line and its start\n", text.size(),
+           static_cast<long long>(snapshot->lineCount()), lookups);
+
+    FakeView view(text);
+    Sci_Position sum = 0;
+    start = std::chrono::steady_clock::now();
+    std::thread([&] {
+        sum = lookUp(positions, [&](Sci_Position p) { return snapshot->lineFromPosition(p); },
+                     [&](Sci_Position line) { return snapshot->lineStart(line); });
+    }).join();
+    report("LineSnapshot, worker", lookups, since(start), sum);
+
+    ScintillaCall& direct = view;
+    start = std::chrono::steady_clock::now();
+    sum = lookUp(positions, [&](Sci_Position p) { return direct.call(SCI_LINEFROMPOSITION, p); },
+                 [&](Sci_Position line) { return direct.call(SCI_POSITIONFROMLINE, line); });
+    report("view, own thread", lookups, since(start), sum);
+
+    MarshalledCall marshalled(view);
+    std::thread viewThread([&] { marshalled.serve(); });
+    start = std::chrono::steady_clock::now();
+    std::thread([&] {
+        sum = lookUp(positions, [&](Sci_Position p) { return marshalled.call(SCI_LINEFROMPOSITION, p, 0); },
+                     [&](Sci_Position line) { return marshalled.call(SCI_POSITIONFROMLINE, line, 0); });
+    }).join();
+    report("view, from a worker", lookups, since(start), sum);
+    marshalled.stop();
+    viewThread.join();
+
+    // Typing and deleting at random places, some of it line ends.
+    static const char* const inserts[] = { "a", "word ", "\n", "\r\n", "line\n", "\n\n" };
+    double editMs = 0;
+    for (size_t i = 0; i < edits; i++) {
+        TextEdit edit;
+        edit.position = random() % (text.size() + 1);
+        if (random() % 3) {
+            const std::string insert = inserts[random() % (sizeof(inserts) / sizeof(inserts[0]))];
+            text.insert(static_cast<size_t>(edit.position), insert);
+            edit.removed = 0;
+            edit.inserted = static_cast<Sci_Position>(insert.size());
+        } else {
+            edit.removed = std::min<Sci_Position>(random() % 8, static_cast<Sci_Position>(text.size()) - edit.position);
+            text.erase(static_cast<size_t>(edit.position), static_cast<size_t>(edit.removed));
+            edit.inserted = 0;
+        }
+        TextDocumentView document(text);
+        start = std::chrono::steady_clock::now();
+        index.applyEdit(document, edit);
+        editMs += since(start);
+    }
+    printf("index: reset %.1f ms, %.1f us per edit over %zu edits\n", resetMs, edits ? editMs * 1000 / edits : 0.0,
+           edits);
+
+    // The index must still agree with a view of the edited text.
+    FakeView edited(text);
+    const std::shared_ptr<const LineSnapshot> current = index.snapshot();
+    if (current->lineCount() != edited.call(SCI_GETLINECOUNT, 0, 0)) {
+        printf("FAILED: the index has %lld lines after the edits, the text %lld\n",
+               static_cast<long long>(current->lineCount()), static_cast<long long>(edited.call(SCI_GETLINECOUNT, 0, 0)));
+        return 1;
+    }
+    return 0;
+}
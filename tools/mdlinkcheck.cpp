@@ -0,0 +1,104 @@
+// Checks the relative links and #anchors of a documentation tree from the
+// command line, with the same engine and index format as the plugin.
+//
+//   mdlinkcheck [--index FILE] [--stats] ROOT [FILE...]
+//
+// Every Markdown file under ROOT is indexed, or only the FILEs given are
+// checked. With --index the index is loaded from FILE and written back, so
+// a later run only parses what changed. Broken links are printed as
+// path:line:column: problem: target, and the exit status is 1 when there
+// are any.
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../core/LinkChecker.h"
+#include "../core/MarkdownSummary.h"
+#include "../core/WorkspaceIndex.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int usage()
+{
+    fprintf(stderr, "usage: mdlinkcheck [--index FILE] [--stats] ROOT [FILE...]\n");
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    fs::path indexPath;
+    bool stats = false;
+    std::vector<fs::path> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            indexPath = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) return usage();
+
+    std::error_code error;
+    const fs::path root = fs::absolute(paths.front(), error).lexically_normal();
+    if (error || !fs::is_directory(root, error)) {
+        fprintf(stderr, "mdlinkcheck: %s is not a directory\n", paths.front().string().c_str());
+        return 2;
+    }
+
+    ThreadPool& pool = ThreadPool::shared();
+    CancelToken cancel;
+    std::shared_ptr<const WorkspaceIndex> previous;
+    if (!indexPath.empty()) previous = WorkspaceIndex::open(indexPath, root);
+    WorkspaceBuild build;
+    std::shared_ptr<const WorkspaceIndex> index =
+        WorkspaceIndex::build(previous, root, findMarkdownFiles(root, cancel), true, pool, cancel, build);
+    if (!indexPath.empty() && index != previous && !index->save(indexPath)) {
+        fprintf(stderr, "mdlinkcheck: cannot write %s\n", indexPath.string().c_str());
+    }
+
+    LinkChecker checker;
+    std::vector<BrokenLink> broken;
+    if (paths.size() == 1) {
+        broken = checker.checkWorkspace(*index, pool, cancel);
+    } else {
+        MarkdownSummary summary;
+        for (size_t i = 1; i < paths.size(); i++) {
+            const fs::path path = fs::absolute(paths[i], error).lexically_normal();
+            std::ifstream in(path, std::ios::binary);
+            if (!in) {
+                fprintf(stderr, "mdlinkcheck: cannot read %s\n", paths[i].string().c_str());
+                continue;
+            }
+            const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            summarizeMarkdown(text, summary);
+            std::vector<BrokenLink> found = checker.checkDocument(path, summary, root, index.get(), pool, cancel);
+            broken.insert(broken.end(), found.begin(), found.end());
+        }
+    }
+
+    for (const BrokenLink& link : broken) {
+        printf("%s:%d:%d: %s: %s\n", WorkspaceIndex::relativePath(link.file, root).c_str(), link.line + 1,
+               link.column + 1, linkProblemName(link.problem), link.target.c_str());
+    }
+    if (stats) {
+        const LinkCheckStats& s = checker.lastStats();
+        fprintf(stderr, "index: %zu files, %zu parsed, %zu unchanged, %zu removed\n", index->fileCount(),
+                build.parsed, build.unchanged + build.touched, build.removed);
+        fprintf(stderr, "check: %zu links, %zu targets in %zu directories (%zu listed), %zu anchor files (%zu parsed)\n",
+                s.links, s.targets, s.directories, s.directoriesListed, s.anchorFiles, s.anchorsParsed);
+    }
+    return broken.empty() ? 0 : 1;
+}
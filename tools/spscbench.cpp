@@ -0,0 +1,123 @@
+// Throughput of SpscQueue against a mutex around a std::deque, the handoff
+// it replaced, with one producer thread and one consumer thread.
+//
+//   spscbench [ITEMS]
+//
+// "polling" has the consumer poll the queue, yielding when it is empty;
+// "woken" has it sleep on a condition variable until the producer reports
+// it idle, the way the plugin's UI thread waits for style results.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "../core/SpscQueue.h"
+
+namespace {
+
+const size_t capacity = 1024;
+
+class LockedQueue
+{
+public:
+    bool push(size_t&& value, bool* idle)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.size() == capacity) return false;
+        *idle = items_.empty();
+        items_.push_back(value);
+        return true;
+    }
+
+    bool pop(size_t& value)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) return false;
+        value = items_.front();
+        items_.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<size_t> items_;
+};
+
+class Wake
+{
+public:
+    void signal()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        signalled_ = true;
+        cv_.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return signalled_; });
+        signalled_ = false;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool signalled_ = false;
+};
+
+template <typename Queue>
+void run(const char* name, bool woken, size_t items)
+{
+    static Queue queue;
+    Wake wake;
+    size_t wakes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        for (size_t i = 0; i < items; i++) {
+            size_t value = i;
+            bool idle = false;
+            while (!queue.push(std::move(value), &idle)) std::this_thread::yield();
+            if (idle && woken) {
+                wakes++;
+                wake.signal();
+            }
+        }
+    });
+
+    size_t received = 0;
+    size_t sum = 0;
+    while (received < items) {
+        if (woken) wake.wait();
+        size_t value;
+        bool any = false;
+        while (queue.pop(value)) {
+            sum += value;
+            received++;
+            any = true;
+        }
+        if (!any && !woken) std::this_thread::yield();
+    }
+    producer.join();
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const bool ok = (sum == items * (items - 1) / 2);
+    printf("%-20s %-8s %8.1f ms %8.1f M items/s %9zu wake-ups%s\n", name, woken ? "woken" : "polling", ms,
+           items / ms / 1000, wakes, ok ? "" : "  WRONG SUM");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const size_t items = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 20000000;
+    run<SpscQueue<size_t, capacity>>("SpscQueue", false, items);
+    run<LockedQueue>("mutex + deque", false, items);
+    run<SpscQueue<size_t, capacity>>("SpscQueue", true, items);
+    run<LockedQueue>("mutex + deque", true, items);
+    return 0;
+}
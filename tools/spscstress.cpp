@@ -0,0 +1,189 @@
+// Stress test for SpscQueue and the StyleWorker result handoff built on it.
+//
+//   spscstress [ITEMS]
+//
+// The queue test runs a producer and a consumer thread at several
+// capacities. The consumer only drains when woken, the way the plugin's UI
+// thread does, so a lost wake-up shows up as a wait that times out rather
+// than as a slow run. Every item must arrive once and in order.
+//
+// The worker test plays the UI thread against a StyleWorker: it submits
+// bursts of jobs that supersede one another and takes results on each wake
+// until the last job of the burst arrives. Results must only move forward
+// and be lexed the same as lexMarkdown() would.
+//
+// Prints what failed and exits with 1 when anything did.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/SpscQueue.h"
+#include "../core/StyleWorker.h"
+
+namespace {
+
+const std::chrono::seconds wakeTimeout(5);
+
+// A flag the producer side raises and the consumer waits for and lowers.
+class Wake
+{
+public:
+    void signal()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        signalled_ = true;
+        cv_.notify_one();
+    }
+
+    // False when nothing came within wakeTimeout.
+    bool wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_for(lock, wakeTimeout, [this] { return signalled_; })) return false;
+        signalled_ = false;
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool signalled_ = false;
+};
+
+int failures = 0;
+
+void fail(const char* what, unsigned long long detail)
+{
+    printf("FAILED: %s (%llu)\n", what, detail);
+    failures++;
+}
+
+template <size_t Capacity>
+void stressQueue(size_t items)
+{
+    // unique_ptr payloads catch a slot that is read twice or never moved out.
+    static SpscQueue<std::unique_ptr<size_t>, Capacity> queue;
+    Wake wake;
+    size_t wakes = 0;
+    std::thread producer([&] {
+        std::mt19937 random(static_cast<unsigned>(Capacity));
+        for (size_t i = 0; i < items; i++) {
+            std::unique_ptr<size_t> item(new size_t(i));
+            bool idle = false;
+            while (!queue.push(std::move(item), &idle)) std::this_thread::yield();
+            if (idle) {
+                wakes++;
+                wake.signal();
+            }
+            // Now and then let the consumer catch up and go idle.
+            if (random() % 1024 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+
+    size_t expected = 0;
+    bool ordered = true;
+    bool woken = true;
+    while (expected < items) {
+        if (!wake.wait()) {
+            woken = false;
+            break;
+        }
+        std::unique_ptr<size_t> item;
+        while (queue.pop(item)) {
+            if (!item || *item != expected) ordered = false;
+            expected++;
+        }
+    }
+    producer.join();
+
+    printf("queue of %zu: %zu items, %zu wake-ups\n", Capacity, expected, wakes);
+    if (!woken) fail("lost wake-up: the consumer waited with items queued", expected);
+    if (!ordered) fail("items out of order or lost", Capacity);
+    if (!queue.empty()) fail("items left in the queue", Capacity);
+}
+
+// Markdown with a bit of every block kind, different for each seed.
+std::string sampleText(unsigned seed, size_t lines)
+{
+    static const char* const blocks[] = {
+        "# Heading\n", "Some *emphasis*, **strong** and `code` with a [link](a.md#b).\n",
+        "- item\n  - nested item\n", "> quoted\n> text\n", "```cpp\nint main() { return 0; }\n```\n",
+        "| a | b |\n|---|---|\n| 1 | 2 |\n", "\n", "Setext\n---\n", "1. first\n2. second\n",
+    };
+    std::mt19937 random(seed);
+    std::string text;
+    for (size_t i = 0; i < lines; i++) text += blocks[random() % (sizeof(blocks) / sizeof(blocks[0]))];
+    return text;
+}
+
+void stressWorker(size_t bursts)
+{
+    const size_t textCount = 8;
+    std::vector<std::string> texts;
+    std::vector<LexOutput> expected(textCount);
+    for (size_t i = 0; i < textCount; i++) {
+        texts.push_back(sampleText(static_cast<unsigned>(i), 200 + 400 * i));
+        lexMarkdown(texts[i], 0, true, expected[i]);
+    }
+
+    TaskScheduler scheduler(3);
+    Wake wake;
+    StyleWorker worker(scheduler, [&wake] { wake.signal(); });
+    std::mt19937 random(7);
+    uint64_t version = 0;
+    uint64_t lastTaken = 0;
+    size_t taken = 0;
+    size_t waits = 0;
+    for (size_t burst = 0; burst < bursts && !failures; burst++) {
+        const size_t jobs = 1 + random() % 3;
+        for (size_t j = 0; j < jobs; j++) {
+            StyleJob job;
+            job.version = ++version;
+            job.text = texts[version % textCount];
+            worker.submit(1, std::move(job));
+        }
+
+        // A job that finished before the next was submitted is not stale,
+        // so its result may come first; superseded ones are skipped.
+        StyleResult result;
+        while (!failures && result.version != version) {
+            if (!worker.take(result)) {
+                waits++;
+                if (!wake.wait()) fail("lost wake-up: no result for the last job", version);
+                continue;
+            }
+            taken++;
+            if (result.version <= lastTaken) fail("take() went back to an older result", result.version);
+            lastTaken = result.version;
+            const LexOutput& want = expected[result.version % textCount];
+            if (result.out.styles != want.styles || result.out.lineStates != want.lineStates) {
+                fail("the result differs from lexMarkdown()", result.version);
+            }
+        }
+    }
+    scheduler.stop();
+    printf("worker: %llu jobs, %zu results taken, %zu waits\n", static_cast<unsigned long long>(version), taken,
+           waits);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const size_t items = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 2000000;
+    stressQueue<2>(items / 4);
+    stressQueue<4>(items / 2);
+    stressQueue<1024>(items);
+    stressWorker(2000);
+    if (failures) return 1;
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Checks applyTheme() and ViewStyles against a fake view that records the
+// messages sent to it and keeps the style fields they set.
+//
+//   themecheck
+//
+// Re-applying the theme a view already holds must send nothing; switching
+// themes must send only the fields that differ and leave the view as a
+// full apply of the new theme would. Prints what failed and exits with 1
+// when anything did.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "../core/MarkdownThemes.h"
+
+namespace {
+
+// The fields applyTheme() sets, as the view holds them.
+struct FakeStyle
+{
+    uint32_t fore = NO_COLOUR;
+    uint32_t back = NO_COLOUR;
+    unsigned flags = 0;
+    int size = 0;
+    std::string font;
+
+    bool operator==(const FakeStyle& other) const
+    {
+        return fore == other.fore && back == other.back && flags == other.flags && size == other.size &&
+               font == other.font;
+    }
+};
+
+// A RecordingScintillaCall that also applies the style messages.
+class FakeView
+{
+public:
+    FakeView()
+    {
+        scintilla.reply = [this](unsigned int message, uptr_t wParam, sptr_t lParam) -> sptr_t {
+            if (wParam >= MARKDOWN_STYLE_COUNT) {
+                unexpected++;
+                return 0;
+            }
+            FakeStyle& style = styles[wParam];
+            switch (message) {
+            case SCI_STYLESETFORE: style.fore = static_cast<uint32_t>(lParam); break;
+            case SCI_STYLESETBACK: style.back = static_cast<uint32_t>(lParam); break;
+            case SCI_STYLESETSIZE: style.size = static_cast<int>(lParam); break;
+            case SCI_STYLESETFONT: style.font = reinterpret_cast<const char*>(lParam); break;
+            case SCI_STYLESETBOLD: if (lParam) style.flags |= STYLEFLAG_BOLD; break;
+            case SCI_STYLESETITALIC: if (lParam) style.flags |= STYLEFLAG_ITALIC; break;
+            case SCI_STYLESETUNDERLINE: if (lParam) style.flags |= STYLEFLAG_UNDERLINE; break;
+            case SCI_STYLESETEOLFILLED: if (lParam) style.flags |= STYLEFLAG_EOLFILLED; break;
+            default: unexpected++; break;
+            }
+            return 0;
+        };
+    }
+
+    bool sameAs(const FakeView& other) const
+    {
+        for (int i = 0; i < MARKDOWN_STYLE_COUNT; i++) {
+            if (!(styles[i] == other.styles[i])) return false;
+        }
+        return true;
+    }
+
+    RecordingScintillaCall scintilla;
+    FakeStyle styles[MARKDOWN_STYLE_COUNT];
+    unsigned unexpected = 0;
+};
+
+// The messages a full apply of theme sends.
+unsigned fieldCount(const Theme& theme)
+{
+    unsigned count = 0;
+    for (const StyleDescriptor& d : theme) {
+        count += (d.fore != NO_COLOUR) + (d.back != NO_COLOUR) + (d.size != 0) + (d.font != nullptr);
+        for (unsigned flag = STYLEFLAG_BOLD; flag <= STYLEFLAG_EOLFILLED; flag <<= 1) count += (d.flags & flag) != 0;
+    }
+    return count;
+}
+
+int failures = 0;
+
+void expect(bool ok, const char* what)
+{
+    if (ok) return;
+    printf("FAILED: %s\n", what);
+    failures++;
+}
+
+}
+
+int main()
+{
+    FakeView light;
+    FakeView dark;
+    applyTheme(light.scintilla, nullptr, lightTheme);
+    applyTheme(dark.scintilla, nullptr, darkTheme);
+    expect(light.scintilla.total() == fieldCount(lightTheme), "a full apply sends every field lightTheme sets");
+    expect(dark.scintilla.total() == fieldCount(darkTheme), "a full apply sends every field darkTheme sets");
+    expect(!light.sameAs(dark), "the themes differ");
+
+    FakeView view;
+    ViewStyles record;
+    applyTheme(view.scintilla, &record, lightTheme);
+    expect(record.theme == lightTheme, "the view records the theme applied");
+    expect(view.scintilla.total() == fieldCount(lightTheme), "a view with no record gets every field");
+    expect(view.sameAs(light), "the view holds lightTheme");
+
+    view.scintilla.reset();
+    applyTheme(view.scintilla, &record, lightTheme);
+    expect(view.scintilla.total() == 0, "re-applying the theme the view holds sends nothing");
+
+    view.scintilla.reset();
+    applyTheme(view.scintilla, &record, darkTheme);
+    const unsigned switched = view.scintilla.total();
+    expect(switched > 0 && switched < fieldCount(darkTheme), "switching themes sends only what differs");
+    expect(view.scintilla.count(SCI_STYLESETBOLD) == 0 && view.scintilla.count(SCI_STYLESETITALIC) == 0,
+           "switching themes sends no flags");
+    expect(view.sameAs(dark), "the view holds darkTheme after switching");
+
+    view.scintilla.reset();
+    applyTheme(view.scintilla, &record, darkTheme);
+    expect(view.scintilla.total() == 0, "re-applying after a switch sends nothing");
+
+    view.scintilla.reset();
+    applyTheme(view.scintilla, &record, lightTheme);
+    expect(view.scintilla.total() == switched, "switching back sends as much as switching");
+    expect(view.sameAs(light), "the view holds lightTheme after switching back");
+
+    // What resetStyles() and a reinstalled lexer do to the record.
+    record.theme = nullptr;
+    view.scintilla.reset();
+    applyTheme(view.scintilla, &record, lightTheme);
+    expect(view.scintilla.total() == fieldCount(lightTheme), "a cleared record gets every field again");
+
+    expect(light.unexpected + dark.unexpected + view.unexpected == 0, "only style setters are sent");
+    printf("themecheck: full apply %u messages, switch %u\n", fieldCount(lightTheme), switched);
+    if (failures) return 1;
+    printf("ok\n");
+    return 0;
+}
@@ -44,14 +44,36 @@ cl ^
  /c ^
  /EHsc ^
  /Zi ^
+ /std:c++17 ^
  /DUNICODE ^
  /D_UNICODE ^
  /DNOMINMAX ^
  /DWIN32 ^
  /DWIN64 ^
  /I"..\plugin" ^
- /Foobj\BetterMd.obj ^
- "..\BetterMd.cpp"
+ /Foobj\ ^
+ "..\BetterMd.cpp" ^
+ "..\core\LineClassifier.cpp" ^
+ "..\core\MarkdownLexer.cpp" ^
+ "..\core\MarkdownILexer.cpp" ^
+ "..\core\NotificationQueue.cpp" ^
+ "..\core\StylePalette.cpp" ^
+ "..\core\DocumentView.cpp" ^
+ "..\core\ThreadPool.cpp" ^
+ "..\core\ParallelLexer.cpp" ^
+ "..\core\StyleWorker.cpp" ^
+ "..\core\TaskScheduler.cpp" ^
+ "..\core\Arena.cpp" ^
+ "..\core\BlockTree.cpp" ^
+ "..\core\DocumentBlocks.cpp" ^
+ "..\core\LineIndex.cpp" ^
+ "..\core\CodeLexer.cpp" ^
+ "..\core\HeadingIndex.cpp" ^
+ "..\core\MarkdownSummary.cpp" ^
+ "..\core\MappedFile.cpp" ^
+ "..\core\WorkspaceIndex.cpp" ^
+ "..\core\LinkChecker.cpp" ^
+ "..\core\LinkCompletion.cpp"
 
 if errorlevel 1 (
     echo Compilation failed.
@@ -64,7 +86,7 @@ echo Linking BetterMd.dll...
 link ^
  /DLL ^
  /OUT:bin\BetterMd.dll ^
- obj\BetterMd.obj ^
+ obj\*.obj ^
  user32.lib gdi32.lib comctl32.lib
 
 if errorlevel 1 (
@@ -81,6 +103,7 @@ echo Output: vs.proj\bin\BetterMd.dll
 echo.
 echo To install plugin:
 echo   %%APPDATA%%\Notepad++\plugins\BetterMd\BetterMd.dll
+echo   %%APPDATA%%\Notepad++\plugins\Config\BetterMd.xml  (from plugin\BetterMd.xml)
 echo.
 
 pause